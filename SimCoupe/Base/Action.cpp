@@ -31,6 +31,7 @@
 #include "Input.h"
 #include "Options.h"
 #include "Parallel.h"
+#include "Rewind.h"
 #include "Sound.h"
 #include "Tape.h"
 #include "UI.h"
@@ -46,7 +47,8 @@ const char* Action::aszActions[MAX_ACTION] =
     "Toggle Smoothing", "Toggle scanlines", "Toggle greyscale", "Mute sound", "Release mouse capture",
     "Toggle printer online", "Flush printer", "About SimCoupe", "Minimise window", "Record GIF animation", "Record GIF loop",
     "Stop GIF Recording", "Record WAV audio", "Record WAV segment", "Stop WAV Recording", "Record AVI video", "Record AVI half-size", "Stop AVI Recording",
-    "Speed Faster", "Speed Slower", "Speed Normal", "Paste Clipboard", "Insert Tape", "Eject Tape", "Tape Browser"
+    "Speed Faster", "Speed Slower", "Speed Normal", "Paste Clipboard", "Insert Tape", "Eject Tape", "Tape Browser",
+    "Rewind (when held)"
 };
 
 
@@ -212,6 +214,10 @@ bool Action::Do (int nAction_, bool fPressed_/*=true*/)
                 }
                 break;
 
+            case actRewind:
+                Rewind::SetActive(true);
+                break;
+
             case actReleaseMouse:
                 Input::AcquireMouse(false);
                 Frame::SetStatus("Mouse capture released");
@@ -337,6 +343,10 @@ bool Action::Do (int nAction_, bool fPressed_/*=true*/)
                 g_nTurbo = 0;
                 break;
 
+            case actRewind:
+                Rewind::SetActive(false);
+                break;
+
             // Not processed
             default:
                 return false;
@@ -63,6 +63,22 @@ void Blip_Buffer::clear( int entire_buffer )
 	}
 }
 
+void Blip_Buffer::save_state( blip_buffer_state_t* out )
+{
+	assert( samples_avail() == 0 );
+	out->offset_       = offset_;
+	out->reader_accum_ = reader_accum;
+	memcpy( out->buf, &buffer_ [offset_ >> BLIP_BUFFER_ACCURACY], sizeof out->buf );
+}
+
+void Blip_Buffer::load_state( blip_buffer_state_t const& in )
+{
+	clear( false );
+	offset_      = in.offset_;
+	reader_accum = in.reader_accum_;
+	memcpy( buffer_, in.buf, sizeof in.buf );
+}
+
 Blip_Buffer::blargg_err_t Blip_Buffer::set_sample_rate( long new_rate, int msec )
 {
 	// start with maximum length that resampled time can represent
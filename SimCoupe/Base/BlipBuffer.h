@@ -13,6 +13,8 @@ typedef long blip_time_t;
 typedef short blip_sample_t;
 enum { blip_sample_max = 32767 };
 
+struct blip_buffer_state_t;
+
 class Blip_Buffer {
 public:
 	typedef const char* blargg_err_t;
@@ -53,6 +55,11 @@ public:
 	// Number of samples delay from synthesis to samples read out
 	int output_latency() const;
 	
+	// Save/load current state of buffer. Only valid once all samples have been read
+	// out, such as between frames (samples_avail() must be zero).
+	void save_state( blip_buffer_state_t* out );
+	void load_state( blip_buffer_state_t const& in );
+	
 	// Remove all available samples and clear buffer to silence. If 'entire_buffer' is
 	// false, just clears out any samples waiting rather than the entire buffer.
 	void clear( int entire_buffer = 1 );
@@ -131,8 +138,16 @@ private:
 	typedef unsigned long blip_resampled_time_t;
 	int const blip_widest_impulse_ = 16;
 	int const blip_res = 1 << BLIP_PHASE_BITS;
+	int const blip_buffer_extra_ = blip_widest_impulse_ + 2;
 	class blip_eq_t;
 	
+	struct blip_buffer_state_t
+	{
+		blip_resampled_time_t offset_;
+		long reader_accum_;
+		long buf [blip_buffer_extra_];
+	};
+	
 	class Blip_Synth_ {
 		double volume_unit_;
 		short* const impulses;
@@ -171,6 +186,10 @@ public:
 	Blip_Buffer* output() const                 { return impl.buf; }
 	void output( Blip_Buffer* b )               { impl.buf = b; impl.last_amp = 0; }
 	
+	// Get/set last amplitude passed to update(), for saving and restoring state
+	int last_amp() const                        { return impl.last_amp; }
+	void last_amp( int a )                      { impl.last_amp = a; }
+	
 	// Update amplitude of waveform at given time. Using this requires a separate
 	// Blip_Synth for each waveform.
 	void update( blip_time_t time, int amplitude );
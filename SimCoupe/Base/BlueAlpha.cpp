@@ -38,6 +38,7 @@
 #include "CPU.h"
 #include "Options.h"
 #include "Sound.h"
+#include "State.h"
 
 #define PORTA_CLOCK             0x01
 #define PORTB_DAC_ENABLE        0x01
@@ -66,6 +67,15 @@ bool CBlueAlphaDevice::Clock ()
     return !!(~m_bPortB & (PORTB_DAC_ENABLE|PORTB_ADC_ENABLE));
 }
 
+// Save or restore the 8255 port values, which also give the state of the clock
+void CBlueAlphaDevice::Serialize (CState &state_)
+{
+    state_.Value(m_bControl);
+    state_.Value(m_bPortA);
+    state_.Value(m_bPortB);
+    state_.Value(m_bPortC);
+}
+
 int CBlueAlphaDevice::GetClockFreq ()
 {
     int freq = GetOption(samplerfreq);
@@ -36,6 +36,8 @@ class CBlueAlphaDevice : public CIoDevice
         BYTE In (WORD wPort_);
         void Out (WORD wPort_, BYTE bVal_);
 
+        void Serialize (CState &state_);
+
     public:
         int GetClockFreq ();
         bool Clock ();
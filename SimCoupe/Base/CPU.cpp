@@ -40,8 +40,13 @@
 #include "Input.h"
 #include "IO.h"
 #include "Memory.h"
+#include "MIDI.h"
 #include "Mouse.h"
 #include "Options.h"
+#include "Profile.h"
+#include "Rewind.h"
+#include "Sound.h"
+#include "State.h"
 #include "Tape.h"
 #include "UI.h"
 #include "Util.h"
@@ -49,6 +54,11 @@
 
 #undef USE_FLAG_TABLES      // Experimental - disabled for now
 
+// Threaded dispatch for the main CPU loop needs the GCC labels-as-values extension
+#if defined(__GNUC__) && !defined(USE_LOWRES) && !defined(USE_ONECPUCORE) && !defined(_DEBUG) && !defined(NO_THREADED_CPU)
+#define USE_THREADED_CPU
+#endif
+
 // Look up table for the parity (and other common flags) for logical operations
 BYTE g_abParity[256];
 #define parity(a) (g_abParity[a])
@@ -74,7 +84,8 @@ inline void CheckInterrupt ();
 //                  CPU can only access memory 1 out of every 8 T-States
 //              else
 //                  CPU can only access memory 1 out of every 4 T-States
-#define MEM_ACCESS(a)   do { g_dwCycleCounter += 3; if (afSectionContended[AddrSection(a)]) g_dwCycleCounter += pContention[g_dwCycleCounter]; } while (0)
+//          The table holds the access mask (7 or 3) for each 8 T-State cell, and the access waits for the next slot
+#define MEM_ACCESS(a)   do { g_dwCycleCounter += 3; const BYTE *pb_ = apbSectionContention[AddrSection(a)]; if (pb_) g_dwCycleCounter = ((g_dwCycleCounter+1) | pb_[g_dwCycleCounter >> 3]) - 1; } while (0)
 
 // Update g_nLineCycle for one port access
 // This is the basic four T-State CPU I/O access
@@ -89,14 +100,15 @@ bool g_fReset, g_fBreak, g_fPaused;
 int g_nTurbo;
 
 DWORD g_dwCycleCounter;     // Global cycle counter used for various timings
+DWORD g_dwNextCheck;        // Cycle count at which the main loop next checks events, interrupts and breaks
 
 #ifdef _DEBUG
 bool g_fDebug;              // Debug only helper variable, to trigger the debugger when set
 #endif
 
-// Memory access contention table
-BYTE abContention1[TSTATES_PER_FRAME+64], abContention234[TSTATES_PER_FRAME+64], abContentionOff[TSTATES_PER_FRAME+64];
-BYTE *pContention = abContention1;
+// Memory access contention tables, holding the access mask for each 8 T-State cell of the frame
+BYTE abContention1[(TSTATES_PER_FRAME+64) >> 3], abContention234[(TSTATES_PER_FRAME+64) >> 3], abContentionOff[(TSTATES_PER_FRAME+64) >> 3];
+const BYTE *pContention = abContention1;
 //                         T1 T2 T3 T4 T1 T2 T3 T4
 BYTE abPortContention[] = { 6, 5, 4, 3, 2, 1, 0, 7 };
 
@@ -106,7 +118,8 @@ BYTE *pbMemRead1, *pbMemRead2, *pbMemWrite1, *pbMemWrite2;
 Z80Regs regs;
 
 WORD* pHlIxIy, *pNewHlIxIy;
-CPU_EVENT asCpuEvents[MAX_EVENTS], *psNextEvent, *psFreeEvent;
+CPU_EVENT asCpuEvents[MAX_EVENTS+1], *psNextEvent;
+DWORD dwPendingEvents;
 
 
 bool CPU::Init (bool fFirstInit_/*=false*/)
@@ -140,17 +153,18 @@ bool CPU::Init (bool fFirstInit_/*=false*/)
         memset(&regs, 0, sizeof(regs));
         IX = IY = 0xffff;
 
-        // Build the memory access contention tables
-        for (UINT t2 = 0 ; t2 < sizeof(abContention1)/sizeof(abContention1[0]) ; t2++)
+        // Build the memory access contention tables, with a mask per cell as the line length is a multiple of 8
+        for (UINT c = 0 ; c < sizeof(abContention1)/sizeof(abContention1[0]) ; c++)
         {
+            UINT t2 = c << 3;
             int nLine = t2 / TSTATES_PER_LINE, nLineCycle = t2 % TSTATES_PER_LINE;
             bool fScreen = nLine >= TOP_BORDER_LINES && nLine < TOP_BORDER_LINES+SCREEN_LINES &&
                            nLineCycle >= BORDER_PIXELS+BORDER_PIXELS;
             bool fMode1 = !(nLineCycle & 0x40);
 
-            abContention1[t2] = ((t2+1)|((fScreen|fMode1)?7:3)) - 1 - t2;
-            abContention234[t2] = ((t2+1)|(fScreen?7:3)) - 1 - t2;
-            abContentionOff[t2] = ((t2+1)|3) - 1 - t2;
+            abContention1[c] = (fScreen|fMode1) ? 7 : 3;
+            abContention234[c] = fScreen ? 7 : 3;
+            abContentionOff[c] = 3;
         }
 
         // Set up RAM and initial I/O settings
@@ -166,6 +180,7 @@ bool CPU::Init (bool fFirstInit_/*=false*/)
 
 void CPU::Exit (bool fReInit_/*=false*/)
 {
+    Rewind::Exit(fReInit_);
     IO::Exit(fReInit_);
     Memory::Exit(fReInit_);
 }
@@ -176,6 +191,13 @@ void CPU::UpdateContention ()
 {
     pContention = (vmpr_mode == MODE_1) ? abContention1 :
                   (BORD_SOFF && VMPR_MODE_3_OR_4) ? abContentionOff : abContention234;
+
+    // Update the sections holding contended RAM
+    for (int i = 0 ; i < 4 ; i++)
+    {
+        if (apbSectionContention[i])
+            apbSectionContention[i] = pContention;
+    }
 }
 
 
@@ -253,6 +275,7 @@ void CPU::ExecuteEvent (CPU_EVENT sThisEvent)
     switch (sThisEvent.nEvent)
     {
         case evtStdIntEnd:
+        case evtLineIntEnd:
             // Reset the interrupt as we're done
             status_reg |= (STATUS_INT_FRAME | STATUS_INT_LINE);
             break;
@@ -273,7 +296,7 @@ void CPU::ExecuteEvent (CPU_EVENT sThisEvent)
         {
             // Begin the line interrupt and add an event to end it
             status_reg &= ~STATUS_INT_LINE;
-            AddCpuEvent(evtStdIntEnd, sThisEvent.dwTime + INT_ACTIVE_TIME);
+            AddCpuEvent(evtLineIntEnd, sThisEvent.dwTime + INT_ACTIVE_TIME);
 
             AddCpuEvent(evtLineIntStart, sThisEvent.dwTime + TSTATES_PER_FRAME);
             break;
@@ -327,6 +350,8 @@ void CPU::ExecuteEvent (CPU_EVENT sThisEvent)
 // Execute until the end of a frame, or a breakpoint, whichever comes first
 void CPU::ExecuteChunk ()
 {
+    CProfileSection section(PROF_CPU);
+
     // Is the reset button is held in?
     if (g_fReset)
     {
@@ -377,7 +402,72 @@ void CPU::ExecuteChunk ()
 #endif
         }
     }
-#if !defined(USE_LOWRES) && !defined(USE_ONECPUCORE)
+#if defined(USE_THREADED_CPU)
+    else
+    {
+        // Handler address for each opcode, in the order of the labels generated by instr()
+#define OPS8(n)     &&op_##n##0, &&op_##n##1, &&op_##n##2, &&op_##n##3, &&op_##n##4, &&op_##n##5, &&op_##n##6, &&op_##n##7
+        static const void* const apvOps[256] =
+        {
+            OPS8(000), OPS8(001), OPS8(002), OPS8(003), OPS8(004), OPS8(005), OPS8(006), OPS8(007),
+            OPS8(010), OPS8(011), OPS8(012), OPS8(013), OPS8(014), OPS8(015), OPS8(016), OPS8(017),
+            OPS8(020), OPS8(021), OPS8(022), OPS8(023), OPS8(024), OPS8(025), OPS8(026), OPS8(027),
+            OPS8(030), OPS8(031), OPS8(032), OPS8(033), OPS8(034), OPS8(035), OPS8(036), OPS8(037)
+        };
+#undef OPS8
+
+        // Each instruction ends by jumping directly to the next handler, giving the branch predictor
+        // a separate indirect jump per opcode to learn from.  Events, interrupts and breaks are rare,
+        // so they're handled out of line with the same checks and order as the switch-based loop.
+        // Between checks, instructions run straight through to the deadline in g_dwNextCheck.
+#define Z80_DISPATCH \
+            do { \
+                if (g_dwCycleCounter >= g_dwNextCheck) \
+                    goto CheckEvents; \
+                pHlIxIy = pNewHlIxIy; \
+                pNewHlIxIy = &HL; \
+                bOpcode = timed_read_code_byte(PC++); \
+                R++; \
+                goto *apvOps[bOpcode]; \
+            } while (0)
+
+        // Check after the first instruction, in case anything changed while we weren't running
+        g_fBreak = false;
+        g_dwNextCheck = 0;
+        goto NextInstr;
+
+CheckEvents:
+        // Update the line/global counters and check/process for pending events
+        CheckCpuEvents();
+
+        // Are there any active interrupts?
+        if (status_reg != STATUS_INT_NONE && IFF1)
+            CheckInterrupt();
+
+        // Run to the next event, unless an active interrupt needs checking after each instruction.
+        // Interrupts only become active from events, and new events lower the deadline if needed.
+        g_dwNextCheck = (status_reg != STATUS_INT_NONE) ? 0 : psNextEvent->dwTime;
+
+        if (!g_fBreak)
+        {
+NextInstr:
+            // Keep track of the current and previous state of whether we're processing an indexed instruction
+            pHlIxIy = pNewHlIxIy;
+            pNewHlIxIy = &HL;
+
+            // Fetch... (and advance PC)
+            bOpcode = timed_read_code_byte(PC++);
+            R++;
+
+            // ... Decode ...
+            goto *apvOps[bOpcode];
+
+#include "Z80ops.h"     // ... Execute!
+        }
+
+#undef Z80_DISPATCH
+    }
+#elif !defined(USE_LOWRES) && !defined(USE_ONECPUCORE)
     else
     {
         // Loop until we've reached the end of the frame
@@ -409,23 +499,37 @@ void CPU::ExecuteChunk ()
 #endif
         }
     }
-#endif  // !defined(USE_LOWRES) && !defined(USE_ONECPUCORE)
+#endif  // USE_THREADED_CPU
 }
 
 #ifdef RETRO
 extern "C" void CPU_Run1();
+extern "C" void CPU_RunAhead(int nFrames_);
+
+static bool fHiddenFrame;   // Frame image isn't wanted
+static bool fPredicted;     // Frame will be discarded, so don't record it
 
 void CPU_Run1(){
 
-	UI::CheckEvents();
+	// Input and UI events are handled once per real frame, not again for each predicted one
+	if (!fPredicted)
+		UI::CheckEvents();
 
         if (g_fPaused)
             return;
 
+        // While rewinding, restore the previous frame and replay it for display
+        if (Rewind::IsActive() && !Rewind::Step())
+            return;
+
         // If fast booting is active, don't draw any video
         if (g_nTurbo & TURBO_BOOT)
             fDrawFrame = GUI::IsActive();
 
+        // Skip drawing frames that won't be shown
+        if (fHiddenFrame)
+            fDrawFrame = false;
+
         // Prepare start of frame image, in case we've already started it
         Frame::Begin();
 
@@ -447,10 +551,75 @@ void CPU_Run1(){
 
             // Step back up to start the next frame
             g_dwCycleCounter %= TSTATES_PER_FRAME;
+
+            // Record the frame in the rewind history
+            if (!fPredicted)
+                Rewind::FrameEnd();
         }
 
 }
 
+// Run the real frame without drawing it, then show the frame nFrames_ ahead of it,
+// predicted from the current input, to hide the latency of the running software
+void CPU_RunAhead (int nFrames_)
+{
+    static BYTE *pbState;
+    static size_t uStateSize;
+
+    // Run normally if the frames couldn't be replayed as expected
+    if (nFrames_ <= 0 || g_fPaused || g_nTurbo || Rewind::IsActive() || GUI::IsActive() || Debug::IsActive())
+    {
+        CPU_Run1();
+        return;
+    }
+
+    // The same for devices the snapshot can't take back: the tape position, and MIDI messages already sent
+    if (Tape::IsPlaying() || (GetOption(midi) == 1 && pMidi->IsOpen()))
+    {
+        CPU_Run1();
+        return;
+    }
+
+    // The real frame, with its sound but without its image
+    fHiddenFrame = true;
+    CPU_Run1();
+
+    size_t uSize = State::GetSize();
+    if (uSize > uStateSize)
+    {
+        delete[] pbState;
+        pbState = new BYTE[uStateSize = uSize];
+    }
+
+    fHiddenFrame = false;
+
+    // Without a snapshot we can't return, so leave the previous image showing
+    if (!State::Save(pbState, uStateSize))
+        return;
+
+    // Predict ahead silently, drawing only the final frame
+    int nTurbo = g_nTurbo;
+    fPredicted = true;
+    Sound::SetMuted(true);
+
+    for (int i = 0 ; i < nFrames_ ; i++)
+    {
+        fHiddenFrame = (i != nFrames_-1);
+        CPU_Run1();
+    }
+
+    Sound::SetMuted(false);
+    fPredicted = fHiddenFrame = false;
+
+    // The restore only undoes the predicted frames, so it can't affect the display if they changed nothing
+    bool fChanged = fVideoChanged || !fHoldFrame;
+
+    // Return to the real frame, including the turbo state that isn't part of a snapshot
+    State::Load(pbState, uStateSize);
+    g_nTurbo = nTurbo;
+    fVideoChanged = fChanged;
+}
+
 #endif
 
 // The main Z80 emulation loop
@@ -462,6 +631,10 @@ void CPU::Run ()
         if (g_fPaused)
             continue;
 
+        // While rewinding, restore the previous frame and replay it for display
+        if (Rewind::IsActive() && !Rewind::Step())
+            continue;
+
         // If fast booting is active, don't draw any video
         if (g_nTurbo & TURBO_BOOT)
             fDrawFrame = GUI::IsActive();
@@ -487,6 +660,9 @@ void CPU::Run ()
 
             // Step back up to start the next frame
             g_dwCycleCounter %= TSTATES_PER_FRAME;
+
+            // Record the frame in the rewind history
+            Rewind::FrameEnd();
         }
     }
 
@@ -552,6 +728,62 @@ void CPU::NMI()
     g_dwCycleCounter += 2;
 }
 
+// Save or restore the CPU registers, timing and pending events
+void CPU::Serialize (CState &state_)
+{
+    // The tape position isn't part of a snapshot, so a playing tape keeps its next edge across a load
+    DWORD dwTapeEvent = dwPendingEvents & (1U << evtTapeEdge), dwTapeEdge = GetEventTime(evtTapeEdge);
+    DWORD dwEvents = dwPendingEvents & ~(1U << evtTapeEdge);
+
+    state_.Value(regs);
+    state_.Value(g_dwCycleCounter);
+    state_.Value(g_fReset);
+    state_.Value(bOpcode);
+
+    // Events are stored in the order they're due, as type and time pairs
+    BYTE bEvents = 0;
+    for (int n = 0 ; n < MAX_EVENTS ; n++)
+    {
+        if (dwEvents & (1U << n))
+            bEvents++;
+    }
+
+    state_.Value(bEvents);
+
+    if (!state_.IsLoading())
+    {
+        DWORD dwSaved = dwTapeEvent;
+
+        for (CPU_EVENT *psEvent ; (psEvent = GetPendingCpuEvent(dwSaved)) ; dwSaved |= (1U << psEvent->nEvent))
+        {
+            state_.Value(psEvent->nEvent);
+            state_.Value(psEvent->dwTime);
+        }
+    }
+    else
+    {
+        InitCpuEvents();
+
+        for (int i = 0 ; i < bEvents ; i++)
+        {
+            int nEvent = 0;
+            DWORD dwTime = 0;
+
+            state_.Value(nEvent);
+            state_.Value(dwTime);
+
+            if (nEvent >= 0 && nEvent < MAX_EVENTS)
+                AddCpuEvent(nEvent, dwTime);
+        }
+
+        if (dwTapeEvent)
+            AddCpuEvent(evtTapeEdge, g_dwCycleCounter + dwTapeEdge);
+
+        // Index prefix not active between instructions
+        pHlIxIy = pNewHlIxIy = &HL;
+    }
+}
+
 
 inline void CheckInterrupt ()
 {
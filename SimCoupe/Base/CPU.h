@@ -29,6 +29,7 @@
 
 struct _CPU_EVENT;
 struct _Z80Regs;
+class CState;
 
 class CPU
 {
@@ -44,12 +45,14 @@ class CPU
         static void Reset (bool fPress_);
         static void NMI ();
 
+        static void Serialize (CState &state_);
+
         static void InitTests ();
 };
 
 
 extern struct _Z80Regs regs;
-extern DWORD g_dwCycleCounter;
+extern DWORD g_dwCycleCounter, g_dwNextCheck;
 extern bool g_fReset, g_fBreak, g_fPaused;
 extern int g_nTurbo;
 extern BYTE *pbMemRead1, *pbMemRead2, *pbMemWrite1, *pbMemWrite2;
@@ -103,7 +106,6 @@ typedef struct _CPU_EVENT
 {
     int     nEvent;
     DWORD   dwTime;
-    struct  _CPU_EVENT  *psNext;
 }
 CPU_EVENT;
 
@@ -188,92 +190,105 @@ Z80Regs;
 #define IR      ((I << 8) | (R7 & 0x80) | (R & 0x7f))
 
 
-// CPU Event Queue data
+// CPU Event Queue data, with a slot for each event type.  Adding an event replaces any pending one of
+// the same type, so each event source needs its own type (the frame and line interrupts end separately)
 enum {
     evtStdIntEnd, evtLineIntStart, evtEndOfFrame, evtMidiOutIntStart, evtMidiOutIntEnd,
-    evtInputUpdate, evtMouseReset, evtBlueAlphaClock, evtAsicStartup, evtTapeEdge
+    evtInputUpdate, evtMouseReset, evtBlueAlphaClock, evtAsicStartup, evtTapeEdge,
+    evtLineIntEnd,
+    MAX_EVENTS      // must not exceed 32, for the pending mask
 };
 
-const int MAX_EVENTS = 16;
+const DWORD EVENT_TIME_NEVER = 0xffffffff;
+
+// Event slots, plus a sentinel slot that's never due, used when nothing is pending
+extern CPU_EVENT asCpuEvents[MAX_EVENTS+1], *psNextEvent;
+extern DWORD dwPendingEvents;
+
+
+// Find the next event due, with same-time events taken in type order
+inline void FindNextCpuEvent ()
+{
+    psNextEvent = &asCpuEvents[MAX_EVENTS];
+
+    for (int n = 0 ; n < MAX_EVENTS ; n++)
+    {
+        if ((dwPendingEvents & (1U << n)) && asCpuEvents[n].dwTime < psNextEvent->dwTime)
+            psNextEvent = &asCpuEvents[n];
+    }
+}
+
+// Return the earliest pending event whose type isn't in the supplied mask, or NULL if none
+inline CPU_EVENT *GetPendingCpuEvent (DWORD dwSkip_)
+{
+    CPU_EVENT *psEvent = NULL;
 
-extern CPU_EVENT asCpuEvents[MAX_EVENTS], *psNextEvent, *psFreeEvent;
+    for (int n = 0 ; n < MAX_EVENTS ; n++)
+    {
+        if ((dwPendingEvents & ~dwSkip_ & (1U << n)) && (!psEvent || asCpuEvents[n].dwTime < psEvent->dwTime))
+            psEvent = &asCpuEvents[n];
+    }
 
+    return psEvent;
+}
 
 // Initialise the CPU events queue
 inline void InitCpuEvents ()
 {
-    for (int n = 0 ; n < MAX_EVENTS ; n++)
-        asCpuEvents[n].psNext = &asCpuEvents[(n+1) % MAX_EVENTS];
+    for (int n = 0 ; n <= MAX_EVENTS ; n++)
+    {
+        asCpuEvents[n].nEvent = n;
+        asCpuEvents[n].dwTime = EVENT_TIME_NEVER;
+    }
 
-    psFreeEvent = asCpuEvents;
-    psNextEvent = NULL;
+    dwPendingEvents = 0;
+    psNextEvent = &asCpuEvents[MAX_EVENTS];
 }
 
-// Add a CPU event into the queue
+// Add a CPU event into the queue, replacing any pending event of the same type
 inline void AddCpuEvent (int nEvent_, DWORD dwTime_)
 {
-    CPU_EVENT *psNextFree = psFreeEvent->psNext;
-    CPU_EVENT **ppsEvent = &psNextEvent;
-
-    // Search through the queue while the events come before the new one
-    // New events with equal time are inserted after existing entries
-    while (*ppsEvent && (*ppsEvent)->dwTime <= dwTime_)
-        ppsEvent = &((*ppsEvent)->psNext);
-
-    // Set this event (note - psFreeEvent will never be NULL)
-    psFreeEvent->nEvent = nEvent_;
-    psFreeEvent->dwTime = dwTime_;
-
-    // Link the events
-    psFreeEvent->psNext = *ppsEvent;
-    *ppsEvent = psFreeEvent;
-    psFreeEvent = psNextFree;
+    CPU_EVENT *psEvent = &asCpuEvents[nEvent_];
+
+    psEvent->dwTime = dwTime_;
+    dwPendingEvents |= (1U << nEvent_);
+
+    // If the next event has moved we need to search again, otherwise check whether the new one comes first
+    if (psEvent == psNextEvent)
+        FindNextCpuEvent();
+    else if (dwTime_ < psNextEvent->dwTime || (dwTime_ == psNextEvent->dwTime && psEvent < psNextEvent))
+        psNextEvent = psEvent;
+
+    // Make sure the main loop doesn't run past it
+    if (dwTime_ < g_dwNextCheck)
+        g_dwNextCheck = dwTime_;
 }
 
-// Remove events of a specific type from the queue
+// Remove any pending event of a specific type
 inline void CancelCpuEvent (int nEvent_)
 {
-    CPU_EVENT **ppsEvent = &psNextEvent;
+    dwPendingEvents &= ~(1U << nEvent_);
 
-    while (*ppsEvent)
-    {
-        if ((*ppsEvent)->nEvent != nEvent_)
-            ppsEvent = &((*ppsEvent)->psNext);
-        else
-        {
-            CPU_EVENT *psNext = (*ppsEvent)->psNext;
-            (*ppsEvent)->psNext = psFreeEvent;
-            psFreeEvent = *ppsEvent;
-            *ppsEvent = psNext;
-        }
-    }
+    if (psNextEvent == &asCpuEvents[nEvent_])
+        FindNextCpuEvent();
 }
 
 // Return time until the next event of a specific  type
 inline DWORD GetEventTime (int nEvent_)
 {
-    CPU_EVENT *psEvent;
-
-    for (psEvent = psNextEvent ; psEvent ; psEvent = psEvent->psNext)
-    {
-        if (psEvent->nEvent == nEvent_)
-            return psEvent->dwTime - g_dwCycleCounter;
-    }
-
-    return 0;
+    return (dwPendingEvents & (1U << nEvent_)) ? asCpuEvents[nEvent_].dwTime - g_dwCycleCounter : 0;
 }
 
 // Update the line/global counters and check for pending events
 inline void CheckCpuEvents ()
 {
-    // Check for pending CPU events (note - psNextEvent will never be NULL *at this stage*)
+    // Check for pending CPU events (the sentinel is never due)
     while (g_dwCycleCounter >= psNextEvent->dwTime)
     {
-        // Get the event from the queue and remove it before new events are added
+        // Take the event from the queue before it's executed, as it may add new events
         CPU_EVENT sThisEvent = *psNextEvent;
-        psNextEvent->psNext = psFreeEvent;
-        psFreeEvent = psNextEvent;
-        psNextEvent = sThisEvent.psNext;
+        dwPendingEvents &= ~(1U << sThisEvent.nEvent);
+        FindNextCpuEvent();
         CPU::ExecuteEvent(sThisEvent);
     }
 }
@@ -282,8 +297,11 @@ inline void CheckCpuEvents ()
 inline void CpuEventFrame (DWORD dwFrameTime_)
 {
     // Process all queued events, due sometime in the next or a later frame
-    for (CPU_EVENT *psEvent = psNextEvent ; psEvent ; psEvent = psEvent->psNext)
-        psEvent->dwTime -= dwFrameTime_;
+    for (int n = 0 ; n < MAX_EVENTS ; n++)
+    {
+        if (dwPendingEvents & (1U << n))
+            asCpuEvents[n].dwTime -= dwFrameTime_;
+    }
 }
 
 #endif  // CPU_H
@@ -33,6 +33,7 @@
 
 #include "Clock.h"
 #include "Options.h"
+#include "State.h"
 
 
 CClockDevice::CClockDevice ()
@@ -474,3 +475,14 @@ void CDallasClock::SaveState (const char *pcszFile_)
         fclose(f);
     }
 }
+
+// Save or restore the full clock and NVRAM state
+void CDallasClock::Serialize (CState &state_)
+{
+    state_.Value(m_tLast);
+    state_.Value(m_st);
+    state_.Value(m_fBCD);
+    state_.Value(m_bReg);
+    state_.Value(m_abRegs);
+    state_.Value(m_abRAM);
+}
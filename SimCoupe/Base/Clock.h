@@ -86,6 +86,7 @@ class CDallasClock : public CClockDevice
 
         void LoadState (const char *pcszFile_);
         void SaveState (const char *pcszFile_);
+        void Serialize (CState &state_);
 
     protected:
         BYTE m_bReg;                // Currently selected register
@@ -362,6 +362,7 @@ CDebugger::CDebugger (BREAKPT* pBreak_/*=NULL*/)
 
     // Force a break from the main CPU loop, and refresh the debugger display
     g_fBreak = true;
+    g_dwNextCheck = 0;
 }
 
 CDebugger::~CDebugger ()
@@ -1615,13 +1616,21 @@ void CDisView::Draw (CScreen* pScreen_)
 
     pScreen_->DrawString(nX, nY+240, "Events", GREEN_8);
 
-    CPU_EVENT *pEvent = psNextEvent;
-    for (i = 0 ; i < 3 && pEvent ; i++, pEvent = pEvent->psNext)
+    // Show the next few events due, except the regular input update
+    DWORD dwShown = (1U << evtInputUpdate);
+    for (i = 0 ; i < 3 ; i++)
     {
+        CPU_EVENT *pEvent = GetPendingCpuEvent(dwShown);
+        if (!pEvent)
+            break;
+
+        dwShown |= (1U << pEvent->nEvent);
+
         const char *pcszEvent = "????";
         switch (pEvent->nEvent)
         {
             case evtStdIntEnd:       pcszEvent = "IEND"; break;
+            case evtLineIntEnd:      pcszEvent = "LEND"; break;
             case evtLineIntStart:    pcszEvent = "LINE"; break;
             case evtEndOfFrame:      pcszEvent = "FRAM"; break;
             case evtMidiOutIntStart: pcszEvent = "MIDI"; break;
@@ -1630,8 +1639,6 @@ void CDisView::Draw (CScreen* pScreen_)
             case evtBlueAlphaClock:  pcszEvent = "BLUE"; break;
             case evtAsicStartup:     pcszEvent = "ASIC"; break;
             case evtTapeEdge:        pcszEvent = "TAPE"; break;
-
-            case evtInputUpdate:     i--; continue;
         }
 
         sprintf(sz, "%s       T", pcszEvent);
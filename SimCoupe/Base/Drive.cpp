@@ -27,6 +27,7 @@
 #include "Drive.h"
 
 #include "CPU.h"
+#include "State.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -55,6 +56,28 @@ void CDrive::Reset ()
     m_bDataStatus = 0;
 }
 
+// Save or restore the controller state, including any transfer in progress
+void CDrive::Serialize (CState &state_)
+{
+    // The buffer position is stored as an offset
+    UINT uOffset = m_pbBuffer ? static_cast<UINT>(m_pbBuffer - m_abBuffer) : 0;
+
+    state_.Value(m_sRegs);
+    state_.Value(m_bSide);
+    state_.Value(m_bHeadCyl);
+    state_.Value(m_bSectorIndex);
+    state_.Value(m_abBuffer);
+    state_.Value(uOffset);
+    state_.Value(m_uBuffer);
+    state_.Value(m_bDataStatus);
+    state_.Value(m_nState);
+    state_.Value(m_nMotorDelay);
+    state_.Value(m_uActive);
+
+    if (state_.IsLoading())
+        m_pbBuffer = m_abBuffer + min(uOffset, static_cast<UINT>(sizeof(m_abBuffer)));
+}
+
 // Insert a new disk from the named source (usually a file)
 bool CDrive::Insert (const char* pcszSource_, bool fAutoLoad_)
 {
@@ -51,6 +51,7 @@ class CDrive : public CDiskDevice
         void Eject ();
         bool Save () { return m_pDisk && m_pDisk->Save(); }
         void Reset ();
+        void Serialize (CState &state_);
 
     public:
         const char* DiskPath () const { return m_pDisk ? m_pDisk->GetPath() : ""; }
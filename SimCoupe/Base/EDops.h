@@ -29,7 +29,7 @@
 
 // Basic instruction header, specifying opcode and nominal T-States of the first M-Cycle (AFTER the ED code)
 // The first three T-States of the first M-Cycle are already accounted for
-#define edinstr(m1states, opcode)   case opcode: { \
+#define edinstr(m1states, opcode)   case opcode: do { \
                                         g_dwCycleCounter += m1states - 3;
 
 // in R,(C)
@@ -44,9 +44,12 @@
 #include "Options.h"
 #include "OSD.h"
 #include "PNG.h"
+#include "Profile.h"
 #include "Sound.h"
+#include "State.h"
 #include "Util.h"
 #include "UI.h"
+#include "Video.h"
 
 
 // SAM palette colours to use for the floppy drive LED states
@@ -56,6 +59,11 @@ const BYTE ATOMLITE_LED_COLOUR  = 89;       // Blue for Atom Lite
 const BYTE LED_OFF_COLOUR       = GREY_2;   // Grey for off
 const BYTE UNDRAWN_COLOUR       = GREY_2;   // Grey for undrawn screen in debugger
 
+const int OSD_TOP_LINES = 2+CHAR_HEIGHT;         // Lines the LEDs and profile text may cover at the top of the view
+const int OSD_BOTTOM_LINES = 2+CHAR_HEIGHT;      // Lines the LEDs and status text may cover at the bottom
+
+const int MAX_RASTER_EVENTS = 1024;             // Display register changes logged before drawing is forced
+
 const unsigned int STATUS_ACTIVE_TIME = 2500;   // Time the status text is visible for (in ms)
 const unsigned int FPS_IN_TURBO_MODE = 5;       // Number of FPS to limit to in (non-key) Turbo mode
 
@@ -69,11 +77,22 @@ bool fDrawFrame, g_fFlashPhase, fSaveScreen;
 int nFrame;
 
 int nLastLine, nLastBlock;      // Line and block we've drawn up to so far this frame
+int nConvertLine;               // First line not yet converted to the display format, when converting directly
+bool fDirectVideo;              // Convert completed lines to the display format as they're drawn?
+bool fLastDirect;               // Was the last drawn frame converted directly, in full?
+bool fDrawSpans;                // Convert only the changed span of each line, as the display holds the rest?
+bool fVideoChanged;             // Has anything affecting the display changed since the last frame began?
+bool fHoldFrame;                // Is drawing held back, as nothing visible has changed since the last frame?
+WORD wLastLeds;                 // Drive LED colours in the last drawn OSD
+bool fDeferDraw;                // Log display register changes to draw the frame later, rather than drawing at each?
+int nFlash;                     // Frame count for the flash attribute phase
 
 DWORD dwStatusTime;             // Time the status line was made visible
 
 int s_nWidth, s_nHeight;
 
+DWORD g_adwPixelMask[16], g_adwPixelMaskHi[4];  // Ink masks for 4 data bits, or 2 doubled bits for hi-res
+
 char szStatus[128], szProfile[128];
 char szScreenPath[MAX_PATH];
 
@@ -84,6 +103,20 @@ typedef struct
 }
 REGION;
 
+// Display register values in effect up to a raster position, logged in place of drawing to it
+typedef struct
+{
+    WORD wLine;
+    BYTE bBlock;
+    BYTE bBorder, bVmpr;
+    BYTE abClut[N_CLUT_REGS], abMode3Clut[4];
+}
+RASTER_EVENT;
+
+RASTER_EVENT asRasterLog[MAX_RASTER_EVENTS];
+int nRasterEvents;
+
+
 REGION asViews[] =
 {
     { SCREEN_BLOCKS, SCREEN_LINES },
@@ -93,8 +126,17 @@ REGION asViews[] =
     { WIDTH_BLOCKS, HEIGHT_LINES },
 };
 
+static void UpdateNow ();
+static void DrawToRaster ();
+static void DrawTo (int nLine_, int nBlock_);
+static void DrawRasterLog ();
+static WORD GetLedColours ();
 static void DrawOSD (CScreen *pScreen_);
 static void Flip (CScreen *pScreen_);
+static void ConvertLine (int nLine_);
+static void ConvertLines (int nTo_);
+static void ConvertOSDLines ();
+static void CopyLastLine (int nLine_);
 
 
 bool Frame::Init (bool fFirstInit_/*=false*/)
@@ -102,6 +144,21 @@ bool Frame::Init (bool fFirstInit_/*=false*/)
     Exit(true);
     TRACE("Frame::Init(%d)\n", fFirstInit_);
 
+    // Build the byte masks used to expand mode 1+2 data bits to pixels, in memory order
+    for (int i = 0 ; i < 16 ; i++)
+    {
+        BYTE *pb = reinterpret_cast<BYTE*>(&g_adwPixelMask[i]);
+        for (int n = 0 ; n < 4 ; n++)
+            pb[n] = (i & (8 >> n)) ? 0xff : 0x00;
+
+        if (i < 4)
+        {
+            pb = reinterpret_cast<BYTE*>(&g_adwPixelMaskHi[i]);
+            pb[0] = pb[1] = (i & 2) ? 0xff : 0x00;
+            pb[2] = pb[3] = (i & 1) ? 0xff : 0x00;
+        }
+    }
+
     UINT uView = GetOption(borders);
     if (uView >= (sizeof(asViews) / sizeof(asViews[0])))
         uView = 0;
@@ -137,6 +194,7 @@ bool Frame::Init (bool fFirstInit_/*=false*/)
 
     // Drawn screen is the last (initially blank) screen
     pDisplayScreen = pLastScreen;
+    fLastDirect = false;
 
     // Set the renderer display modes
     pFrameLow->SetMode(vmpr);
@@ -190,27 +248,119 @@ void Frame::SetView (UINT uBlocks_, UINT uLines_)
 }
 
 
-// Update the frame image to the current raster position
-void Frame::Update ()
+// A display register is about to change, so update the frame image to the current raster position
+void Frame::Update (bool fDefer_/*=true*/)
+{
+    // If deferring, log the current values to draw up to here at the end of the frame
+    if (fDefer_ && fDeferDraw && fDrawFrame && nRasterEvents < MAX_RASTER_EVENTS)
+    {
+        RASTER_EVENT *pEvent = &asRasterLog[nRasterEvents++];
+
+        int nLine, nBlock = GetRasterPos(&nLine) >> 3;
+        pEvent->wLine = nLine;
+        pEvent->bBlock = nBlock;
+        pEvent->bBorder = border;
+        pEvent->bVmpr = vmpr;
+
+        for (int i = 0 ; i < N_CLUT_REGS ; i++)
+            pEvent->abClut[i] = clut[i];
+
+        for (int i = 0 ; i < 4 ; i++)
+            pEvent->abMode3Clut[i] = mode3clut[i];
+
+        fVideoChanged = true;
+        fHoldFrame = false;
+        return;
+    }
+
+    UpdateNow();
+}
+
+// Something visible is about to change, so update the frame image to the current raster position
+void UpdateNow ()
+{
+    // The frame may now differ from the last, so any drawing held back must catch up
+    fVideoChanged = true;
+    fHoldFrame = false;
+
+    DrawToRaster();
+}
+
+// Draw the frame image up to the current raster position
+void DrawToRaster ()
 {
     // Don't do anything if the current frame is being skipped
     if (!fDrawFrame)
         return;
 
+    CProfileSection section(PROF_FRAME);
+
+    // Draw up to each logged change first, using the values in effect at the time
+    if (nRasterEvents)
+        DrawRasterLog();
+
     // Work out the line and block for the current position
     int nLine, nBlock = GetRasterPos(&nLine) >> 3;
+    DrawTo(nLine, nBlock);
+}
+
+// Replay the logged display register changes, drawing the frame up to each of them
+void DrawRasterLog ()
+{
+    // Keep the live values, to restore afterwards
+    BYTE bBorder = border, bVmpr = vmpr, bVmprMode = vmpr_mode;
+    UINT auClut[N_CLUT_REGS], auMode3Clut[4];
+    memcpy(auClut, clut, sizeof(auClut));
+    memcpy(auMode3Clut, mode3clut, sizeof(auMode3Clut));
+
+    for (int i = 0 ; i < nRasterEvents ; i++)
+    {
+        RASTER_EVENT *pEvent = &asRasterLog[i];
+
+        border = pEvent->bBorder;
+        border_col = BORD_VAL(border);
+        vmpr = pEvent->bVmpr;
+        vmpr_mode = VMPR_MODE;
+
+        for (int j = 0 ; j < N_CLUT_REGS ; j++)
+            clut[j] = pEvent->abClut[j];
 
+        for (int j = 0 ; j < 4 ; j++)
+            mode3clut[j] = pEvent->abMode3Clut[j];
+
+        pFrameLow->SetMode(vmpr);
+        pFrameHigh->SetMode(vmpr);
+
+        DrawTo(pEvent->wLine, pEvent->bBlock);
+    }
+
+    nRasterEvents = 0;
+
+    border = bBorder;
+    border_col = BORD_VAL(border);
+    vmpr = bVmpr;
+    vmpr_mode = bVmprMode;
+    memcpy(clut, auClut, sizeof(auClut));
+    memcpy(mode3clut, auMode3Clut, sizeof(auMode3Clut));
+
+    pFrameLow->SetMode(vmpr);
+    pFrameHigh->SetMode(vmpr);
+}
+
+// Draw the frame image up to the given line and block
+void DrawTo (int nLine_, int nBlock_)
+{
     // Determine the renderer for the last updated line
     bool fHiRes = pScreen->IsHiRes(nLastLine-s_nViewTop);
     CFrame *pFrame = fHiRes ? pFrameHigh : pFrameLow;
 
     // If we're still on the same line as last time we've only got a part line to draw
-    if (nLine == nLastLine)
+    if (nLine_ == nLastLine)
     {
-        if (nBlock > nLastBlock)
+        if (nBlock_ > nLastBlock)
         {
-            pFrame->UpdateLine(pScreen, nLine, nLastBlock, nBlock);
-            nLastBlock = nBlock;
+            pFrame->UpdateLine(pScreen, nLine_, nLastBlock, nBlock_);
+            nLastBlock = nBlock_;
         }
     }
 
@@ -218,7 +368,7 @@ void Frame::Update ()
     else
     {
         // Restrict the range of lines to the visible area
-        int nFrom = max(nLastLine, s_nViewTop), nTo = min(nLine, s_nViewBottom-1);
+        int nFrom = max(nLastLine, s_nViewTop), nTo = min(nLine_, s_nViewBottom-1);
 
         // Is any part of the block visible?
         if (nFrom <= nTo)
@@ -232,15 +382,15 @@ void Frame::Update ()
             }
 
             // Update the last line up to the current scan position
-            if (nTo == nLine)
+            if (nTo == nLine_)
             {
                 // Default to low-res unless a mode 3 screen line
-                bool fHiRes = (vmpr_mode == MODE_3) && IsScreenLine(nLine);
-                pScreen->SetHiRes(nLine-s_nViewTop, fHiRes);
+                bool fHiRes = (vmpr_mode == MODE_3) && IsScreenLine(nLine_);
+                pScreen->SetHiRes(nLine_-s_nViewTop, fHiRes);
 
                 // Determine the appropriate renderer and draw the partial line
                 CFrame *pFrame = fHiRes ? pFrameHigh : pFrameLow;
-                pFrame->UpdateLine(pScreen, nLine, 0, nBlock);
+                pFrame->UpdateLine(pScreen, nLine_, 0, nBlock_);
 
                 // Exclude the line from the block as we've drawn it now
                 nTo--;
@@ -259,9 +409,13 @@ void Frame::Update ()
             }
         }
 
+        // Convert the lines we've now completed to the display format, while they're still in cache
+        if (fDirectVideo)
+            ConvertLines(nLine_);
+
         // Remember the current scan position so we can continue from it next time
-        nLastLine = nLine;
-        nLastBlock = nBlock;
+        nLastLine = nLine_;
+        nLastBlock = nBlock_;
     }
 }
 
@@ -278,23 +432,20 @@ static void CopyBeforeLastUpdate ()
         // Copy the last partial line first
         if (nBottom == (nLastLine-s_nViewTop))
         {
-            BYTE* pLine = pScreen->GetHiResLine(nBottom);
-            BYTE* pLastLine = pLastScreen->GetHiResLine(nBottom);
-
-            int nRight = max(nLastBlock, s_nViewRight) - s_nViewLeft;
+            int nRight = min(nLastBlock, s_nViewRight) - s_nViewLeft;
             if (nRight > 0)
+            {
+                BYTE* pLine = pScreen->GetHiResLine(nBottom);
+                BYTE* pLastLine = pLastScreen->GetHiResLine(nBottom);
                 memcpy(pLine, pLastLine, nRight<<4);
+            }
 
             nBottom--;
         }
 
         // Copy the remaining full lines
         for (int i = 0 ; i <= nBottom ; i++)
-        {
-            BYTE* pLine = pScreen->GetHiResLine(i);
-            BYTE* pLastLine = pLastScreen->GetHiResLine(i);
-            memcpy(pLine, pLastLine, pScreen->GetPitch());
-        }
+            CopyLastLine(i);
     }
 }
 
@@ -311,27 +462,34 @@ static void CopyAfterRaster ()
         // Complete the undrawn section of the current line, if any
         if (nTop == (nLastLine-s_nViewTop))
         {
-            BYTE* pLine = pScreen->GetHiResLine(nTop);
-            BYTE* pLastLine = pLastScreen->GetHiResLine(nTop);
-
             int nOffset = (max(s_nViewLeft, nLastBlock) - s_nViewLeft) << 4;
             int nWidth = pScreen->GetPitch() - nOffset;
             if (nWidth > 0)
+            {
+                BYTE* pLine = pScreen->GetHiResLine(nTop);
+                BYTE* pLastLine = pLastScreen->GetHiResLine(nTop);
                 memcpy(pLine+nOffset, pLastLine+nOffset, nWidth);
+            }
 
             nTop++;
         }
 
         // Copy the remaining lines
         for (int i = nTop ; i < nBottom ; i++)
-        {
-            BYTE* pLine = pScreen->GetHiResLine(i);
-            BYTE* pLastLine = pLastScreen->GetHiResLine(i);
-            memcpy(pLine, pLastLine, pScreen->GetPitch());
-        }
+            CopyLastLine(i);
     }
 }
 
+// Copy a whole view line from the previous frame, at its own resolution so lo-res lines are half the size
+static void CopyLastLine (int nLine_)
+{
+    bool fHiRes;
+    BYTE* pLastLine = pLastScreen->GetLine(nLine_, fHiRes);
+
+    memcpy(pScreen->GetLine(nLine_), pLastLine, pLastScreen->GetWidth(nLine_));
+    pScreen->SetHiRes(nLine_, fHiRes);
+}
+
 // Highlight the current raster position if it's on the visible display
 static void DrawRaster (CScreen *pScreen_)
 {
@@ -368,6 +526,20 @@ void Frame::Begin ()
     if (!fDrawFrame)
         return;
 
+    // Convert lines directly to the display if supported, unless the GUI needs a full frame to overlay
+    fDirectVideo = GetOption(directvideo) && Video::CheckCaps(VCAP_DIRECT) && !GUI::IsActive();
+    fDrawSpans = fDirectVideo && fLastDirect && Video::IsRetained();
+    nConvertLine = 0;
+
+    // If nothing has changed since the last frame began, hold back drawing until something does
+    fHoldFrame = fDirectVideo && fLastDirect && !fVideoChanged && Video::IsCurrent() &&
+                 !GIF::IsRecording() && !AVI::IsRecording();
+    fVideoChanged = false;
+
+    // Log display register changes to draw in one pass at the end of the frame, unless the debugger shows the raster
+    fDeferDraw = GetOption(defervideo) && !Debug::IsActive();
+    nRasterEvents = 0;
+
     // If we're debugging, copy up to the last-update position from the previous frame
     CopyBeforeLastUpdate();
 }
@@ -375,11 +547,16 @@ void Frame::Begin ()
 // Complete the displayed frame at the end of an emulated frame
 void Frame::End ()
 {
-    // Was the current frame drawn?
-    if (fDrawFrame)
+    // Draw a held frame after all if the OSD has changed, or a screenshot or the GUI needs it
+    if (fHoldFrame && (fVideoChanged || fSaveScreen || GUI::IsActive() ||
+                       (GetOption(drivelights) && GetLedColours() != wLastLeds)))
+        fHoldFrame = false;
+
+    // Was the current frame drawn? If it's held, the display still shows the identical last frame
+    if (fDrawFrame && !fHoldFrame)
     {
         // Update the screen to the current raster position
-        Update();
+        DrawToRaster();
 
         // If we're debugging, copy after the raster from the previous frame
         CopyAfterRaster();
@@ -426,12 +603,23 @@ void Frame::End ()
             // Overlay the floppy LEDs and status text
             DrawOSD(pScreen);
 
+            // Convert the rest of a direct frame, including the line the raster stopped on and the OSD areas
+            if (fDirectVideo)
+            {
+                ConvertLines(s_nViewBottom);
+                ConvertOSDLines();
+            }
+
             // Submit the completed frame
             Flip(pScreen);
         }
 
-        // Redraw what's new
-        Redraw();
+        // Redraw what's new, unless the lines have already been converted
+        if (!fDirectVideo || GUI::IsActive())
+            Redraw();
+
+        // Later frames can compare against this one if it went directly to the display
+        fLastDirect = fDirectVideo && !GUI::IsActive();
     }
 
     // Decide whether we should draw the next frame
@@ -445,18 +633,46 @@ void Frame::Flyback ()
     nLastLine = nLastBlock = 0;
 
     // Toggle paper/ink colours every 16 emulated frames for the flash attribute in modes 1 and 2
-    static int nFlash = 0;
     if (!(++nFlash % 16))
+    {
         g_fFlashPhase = !g_fFlashPhase;
 
+        // Flashing only shows in modes 1 and 2, and any change into them is noted anyway
+        if (!VMPR_MODE_3_OR_4)
+            fVideoChanged = true;
+    }
+
     // If the status line has been visible long enough, hide it
     if (szStatus[0] && ((OSD::GetTime() - dwStatusTime) > STATUS_ACTIVE_TIME))
+    {
         szStatus[0] = '\0';
+        fVideoChanged = true;
+    }
 
     // New frame
     nFrame++;
 }
 
+// Save or restore the raster drawing position and flash state
+void Frame::Serialize (CState &state_)
+{
+    state_.Value(nLastLine);
+    state_.Value(nLastBlock);
+    state_.Value(nFlash);
+    state_.Value(g_fFlashPhase);
+    state_.Value(nFrame);
+
+    if (state_.IsLoading())
+    {
+        // Select the line renderers for the restored screen mode
+        pFrameLow->SetMode(vmpr);
+        pFrameHigh->SetMode(vmpr);
+
+        // Memory and registers have changed behind our back
+        fVideoChanged = true;
+    }
+}
+
 
 void Frame::Sync ()
 {
@@ -494,6 +710,14 @@ void Frame::Sync ()
 
         // Format the profile string and reset it
         sprintf(szProfile, "%d%%", nPercent);
+#ifdef RETRO
+        // Include the audio queued for the frontend's audio thread, if it's in use
+        int nLatency, nFill;
+        if (Audio::GetStats(nLatency, nFill))
+            sprintf(szProfile + strlen(szProfile), "  %dms %d%%", nLatency, nFill);
+#endif
+        if (GetOption(profile))
+            fVideoChanged = true;
         TRACE("%s  %d frames\n", szProfile, nFrame);
 
         // Adjust for next time, taking care to preserve any fractional part
@@ -523,6 +747,17 @@ void Frame::Redraw ()
 // Determine the frame difference from last time and flip buffers
 void Flip (CScreen *pScreen_)
 {
+    CProfileSection section(PROF_FLIP);
+
+    // Lines drawn directly are already on the display, so there's nothing to compare
+    if (fDirectVideo && !GUI::IsActive())
+    {
+        pDisplayScreen = pScreen_;
+        swap(pScreen, pLastScreen);
+        swap(pGuiScreen, pLastGuiScreen);
+        return;
+    }
+
     int nHeight = pScreen_->GetHeight() >> (GUI::IsActive() ? 0 : 1);
 
     DWORD* pdwA = reinterpret_cast<DWORD*>(pScreen_->GetLine(0));
@@ -556,6 +791,71 @@ void Flip (CScreen *pScreen_)
 }
 
 
+// Convert completed frame lines up to the one given, holding back any the OSD may overlay
+void ConvertLines (int nTo_)
+{
+    int nFrom = max(nConvertLine, s_nViewTop+OSD_TOP_LINES);
+    nTo_ = min(nTo_, s_nViewBottom-OSD_BOTTOM_LINES);
+
+    for (int i = nFrom ; i < nTo_ ; i++)
+        ConvertLine(i-s_nViewTop);
+
+    nConvertLine = max(nConvertLine, nTo_);
+}
+
+// Convert the lines at the top and bottom of the view, once the OSD has been drawn over them
+void ConvertOSDLines ()
+{
+    int nHeight = s_nViewBottom - s_nViewTop;
+
+    for (int i = 0 ; i < OSD_TOP_LINES ; i++)
+        ConvertLine(i);
+
+    for (int i = nHeight-OSD_BOTTOM_LINES ; i < nHeight ; i++)
+        ConvertLine(i);
+}
+
+// Convert a single view line, or just the part that differs from the last frame if that's all that's needed
+void ConvertLine (int nLine_)
+{
+    bool fHiRes, fLastHiRes;
+    DWORD *pdw = reinterpret_cast<DWORD*>(pScreen->GetLine(nLine_, fHiRes));
+    DWORD *pdwLast = reinterpret_cast<DWORD*>(pLastScreen->GetLine(nLine_, fLastHiRes));
+    int nFrom = 0, nTo = pScreen->GetWidth(nLine_);
+
+    if (fDrawSpans && fHiRes == fLastHiRes)
+    {
+        int nLeft = 0, nRight = nTo >> 2;
+
+        // Trim matching data from both ends, leaving nothing if the line is unchanged
+        while (nLeft < nRight && pdw[nLeft] == pdwLast[nLeft])
+            nLeft++;
+        while (nRight > nLeft && pdw[nRight-1] == pdwLast[nRight-1])
+            nRight--;
+
+        if (nLeft == nRight)
+            return;
+
+        // Round out to the 8-pixel groups the display conversion works in
+        nFrom = (nLeft << 2) & ~7;
+        nTo = ((nRight << 2) + 7) & ~7;
+    }
+
+    Video::DrawLine(pScreen, nLine_, nFrom, nTo);
+}
+
+// Determine the drive LED colours, with drive 1 in the high byte and drive 2 or the Atom in the low byte
+WORD GetLedColours ()
+{
+    BYTE bColour1 = pFloppy1->IsLightOn() ? FLOPPY_LED_COLOUR : LED_OFF_COLOUR;
+
+    bool fAtomActive = pAtom->IsActive() || pAtomLite->IsActive();
+    BYTE bAtomColour = pAtom->IsActive() ? ATOM_LED_COLOUR : ATOMLITE_LED_COLOUR;
+    BYTE bColour2 = pFloppy2->IsLightOn() ? FLOPPY_LED_COLOUR : (fAtomActive ? bAtomColour : LED_OFF_COLOUR);
+
+    return (bColour1 << 8) | bColour2;
+}
+
 // Draw on-screen display indicators, such as the floppy LEDs and the status text
 void DrawOSD (CScreen* pScreen_)
 {
@@ -567,22 +867,16 @@ void DrawOSD (CScreen* pScreen_)
         int nX = 2;
         int nY = ((GetOption(drivelights)-1) & 1) ? nHeight-4 : 2;
 
+        // Remember the colours, so a held frame is drawn if they change
+        wLastLeds = GetLedColours();
+
         // Floppy 1 light
         if (GetOption(drive1))
-        {
-            BYTE bColour = pFloppy1->IsLightOn() ? FLOPPY_LED_COLOUR : LED_OFF_COLOUR;
-            pScreen_->FillRect(nX, nY, 14, 2, bColour);
-        }
+            pScreen_->FillRect(nX, nY, 14, 2, wLastLeds >> 8);
 
         // Floppy 2 or Atom drive light
         if (GetOption(drive2))
-        {
-            bool fAtomActive = pAtom->IsActive() || pAtomLite->IsActive();
-            BYTE bAtomColour = pAtom->IsActive() ? ATOM_LED_COLOUR : ATOMLITE_LED_COLOUR;
-
-            BYTE bColour = pFloppy2->IsLightOn() ? FLOPPY_LED_COLOUR : (fAtomActive ? bAtomColour : LED_OFF_COLOUR);
-            pScreen_->FillRect(nX + 18, nY, 14, 2, bColour);
-        }
+            pScreen_->FillRect(nX + 18, nY, 14, 2, wLastLeds & 0xff);
     }
 
     // We'll use the fixed font for the simple on-screen text
@@ -623,6 +917,7 @@ void Frame::SetStatus (const char *pcszFormat_, ...)
     va_end(pcvArgs);
 
     dwStatusTime = OSD::GetTime();
+    fVideoChanged = true;
     TRACE("Status: %s\n", szStatus);
 }
 
@@ -659,6 +954,12 @@ void Frame::GetAsicData (BYTE *pb0_, BYTE *pb1_, BYTE *pb2_, BYTE *pb3_)
 // Changes on the main screen may generate an artefact by using old data in the new mode (described by Dave Laundon)
 void Frame::ChangeMode (BYTE bNewVmpr_)
 {
+    // Catch up any drawing held back or logged before the mode changes, as the artefact is drawn at the raster
+    if (fHoldFrame || nRasterEvents)
+        UpdateNow();
+
+    fVideoChanged = true;
+
     int nLine, nBlock = GetRasterPos(&nLine) >> 3;
 
     // Action only needs to be taken on main screen lines
@@ -698,6 +999,10 @@ void Frame::ChangeMode (BYTE bNewVmpr_)
 // Handle the screen being enabled, which causes a border pixel artefact (reported by Andrew Collier)
 void Frame::ChangeScreen (BYTE bNewBorder_)
 {
+    // Catch up any logged drawing, as the artefact is drawn at the raster
+    if (nRasterEvents)
+        UpdateNow();
+
     int nLine, nBlock = GetRasterPos(&nLine) >> 3;
 
     // Only draw if the artefact cell is visible
@@ -715,9 +1020,10 @@ void Frame::ChangeScreen (BYTE bNewBorder_)
 // A screen line in a specified range is being written to, so we need to ensure it's up-to-date
 void Frame::TouchLines (int nFrom_, int nTo_)
 {
-    // Is the line being modified in the area since we last updated
-    if (nTo_ >= nLastLine && nFrom_ <= (int)((g_dwCycleCounter - BORDER_PIXELS) / TSTATES_PER_LINE))
-        Update();
+    // Is drawing held back or the frame being skipped, or is the line being modified in the area since we last updated?
+    // Writes after the raster of a drawn frame appear in it anyway, so they don't stop the next being held
+    if (fHoldFrame || !fDrawFrame || (nTo_ >= nLastLine && nFrom_ <= (int)((g_dwCycleCounter - BORDER_PIXELS) / TSTATES_PER_LINE)))
+        UpdateNow();
 }
 
 
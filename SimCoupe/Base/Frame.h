@@ -41,7 +41,7 @@ class Frame
         static void Begin ();
         static void End ();
 
-        static void Update ();
+        static void Update (bool fDefer_=true);
 
         static void TouchLines (int nFrom_, int nTo_);
         static inline void TouchLine (int nLine_) { TouchLines(nLine_, nLine_); }
@@ -59,6 +59,8 @@ class Frame
         static void SetView (UINT uBlocks_, UINT uLines_);
 
         static void SetStatus (const char *pcszFormat_, ...);
+
+        static void Serialize (CState &state_);
 };
 
 
@@ -69,7 +71,7 @@ inline BYTE AttrBg (BYTE bAttr_) { return (((bAttr_) >> 3) & 0xf); }
 inline BYTE AttrFg (BYTE bAttr_) { return ((((bAttr_) >> 3) & 8) | ((bAttr_) & 7)); }
 
 
-extern bool fDrawFrame, g_fFlashPhase;
+extern bool fDrawFrame, fVideoChanged, fHoldFrame, g_fFlashPhase;
 extern int nFrame;
 
 extern int s_nWidth, s_nHeight;         // hi-res pixels
@@ -77,6 +79,7 @@ extern int s_nViewTop, s_nViewBottom;   // in lines
 extern int s_nViewLeft, s_nViewRight;   // in screen blocks
 
 extern WORD g_awMode1LineToByte[SCREEN_LINES];
+extern DWORD g_adwPixelMask[16], g_adwPixelMaskHi[4];
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -127,6 +130,7 @@ class CFrameXx1 : public CFrame
         void ScreenChange (BYTE *pbLine_, int nLine_, int nBlock_, BYTE bNewBorder_);
 
     protected:
+        void AttrBlock (BYTE *pFrame_, BYTE bData_, BYTE bAttr_);
         void LeftBorder (BYTE *pbLine_, int nFrom_, int nTo_);
         void RightBorder (BYTE *pbLine_, int nFrom_, int nTo_);
         void BorderLine (BYTE *pbLine_, int nFrom_, int nTo_);
@@ -134,6 +138,44 @@ class CFrameXx1 : public CFrame
 };
 
 
+template <bool fHiRes_>
+inline void CFrameXx1<fHiRes_>::AttrBlock (BYTE *pFrame_, BYTE bData_, BYTE bAttr_)
+{
+    BYTE bInk = AttrFg(bAttr_), bPaper = AttrBg(bAttr_);
+
+    // toggle the colours if we're in the inverse part of the FLASH cycle
+    if (g_fFlashPhase && (bAttr_ & 0x80))
+        swap(bInk, bPaper);
+
+    BYTE ink = clut[bInk], paper = clut[bPaper];
+
+    // Expand the data bits to byte masks selecting ink over paper, 4 pixels at a time
+    DWORD dwPaper = paper * 0x01010101U, dwDiff = (ink ^ paper) * 0x01010101U;
+
+    if (!fHiRes_)
+    {
+        DWORD adw[2] =
+        {
+            dwPaper ^ (g_adwPixelMask[bData_ >> 4]  & dwDiff),
+            dwPaper ^ (g_adwPixelMask[bData_ & 0xf] & dwDiff)
+        };
+
+        memcpy(pFrame_, adw, sizeof(adw));
+    }
+    else
+    {
+        DWORD adw[4] =
+        {
+            dwPaper ^ (g_adwPixelMaskHi[ bData_ >> 6     ] & dwDiff),
+            dwPaper ^ (g_adwPixelMaskHi[(bData_ >> 4) & 3] & dwDiff),
+            dwPaper ^ (g_adwPixelMaskHi[(bData_ >> 2) & 3] & dwDiff),
+            dwPaper ^ (g_adwPixelMaskHi[ bData_       & 3] & dwDiff)
+        };
+
+        memcpy(pFrame_, adw, sizeof(adw));
+    }
+}
+
 template <bool fHiRes_>
 inline void CFrameXx1<fHiRes_>::LeftBorder (BYTE *pbLine_, int nFrom_, int nTo_)
 {
@@ -198,37 +240,7 @@ void CFrameXx1<fHiRes_>::Mode1Line (BYTE *pbLine_, int nLine_, int nFrom_, int n
         // The actual screen line
         for (int i = nFrom; i < nTo; i++)
         {
-            BYTE bData = *pbDataMem++, bAttr = *pbAttrMem++, bInk = AttrFg(bAttr), bPaper = AttrBg(bAttr);
-
-            // toggle the colours if we're in the inverse part of the FLASH cycle
-            if (g_fFlashPhase && (bAttr & 0x80))
-                swap(bInk, bPaper);
-
-            BYTE ink = clut[bInk], paper = clut[bPaper];
-
-            if (!fHiRes_)
-            {
-                pFrame[0] = (bData & 0x80) ? ink : paper;
-                pFrame[1] = (bData & 0x40) ? ink : paper;
-                pFrame[2] = (bData & 0x20) ? ink : paper;
-                pFrame[3] = (bData & 0x10) ? ink : paper;
-                pFrame[4] = (bData & 0x08) ? ink : paper;
-                pFrame[5] = (bData & 0x04) ? ink : paper;
-                pFrame[6] = (bData & 0x02) ? ink : paper;
-                pFrame[7] = (bData & 0x01) ? ink : paper;
-            }
-            else
-            {
-                pFrame[0]  = pFrame[1]  = (bData & 0x80) ? ink : paper;
-                pFrame[2]  = pFrame[3]  = (bData & 0x40) ? ink : paper;
-                pFrame[4]  = pFrame[5]  = (bData & 0x20) ? ink : paper;
-                pFrame[6]  = pFrame[7]  = (bData & 0x10) ? ink : paper;
-                pFrame[8]  = pFrame[9]  = (bData & 0x08) ? ink : paper;
-                pFrame[10] = pFrame[11] = (bData & 0x04) ? ink : paper;
-                pFrame[12] = pFrame[13] = (bData & 0x02) ? ink : paper;
-                pFrame[14] = pFrame[15] = (bData & 0x01) ? ink : paper;
-            }
-
+            AttrBlock(pFrame, *pbDataMem++, *pbAttrMem++);
             pFrame += fHiRes_ ? 16 : 8;
         }
     }
@@ -258,37 +270,7 @@ void CFrameXx1<fHiRes_>::Mode2Line (BYTE *pbLine_, int nLine_, int nFrom_, int n
         // The actual screen line
         for (int i = nFrom; i < nTo; i++)
         {
-            BYTE bData = *pbDataMem++, bAttr = *pbAttrMem++, bInk = AttrFg(bAttr), bPaper = AttrBg(bAttr);
-
-            // toggle the colours if we're in the inverse part of the FLASH cycle
-            if (g_fFlashPhase && (bAttr & 0x80))
-                swap(bInk, bPaper);
-
-            BYTE ink = clut[bInk], paper = clut[bPaper];
-
-            if (!fHiRes_)
-            {
-                pFrame[0] = (bData & 0x80) ? ink : paper;
-                pFrame[1] = (bData & 0x40) ? ink : paper;
-                pFrame[2] = (bData & 0x20) ? ink : paper;
-                pFrame[3] = (bData & 0x10) ? ink : paper;
-                pFrame[4] = (bData & 0x08) ? ink : paper;
-                pFrame[5] = (bData & 0x04) ? ink : paper;
-                pFrame[6] = (bData & 0x02) ? ink : paper;
-                pFrame[7] = (bData & 0x01) ? ink : paper;
-            }
-            else
-            {
-                pFrame[0]  = pFrame[1]  = (bData & 0x80) ? ink : paper;
-                pFrame[2]  = pFrame[3]  = (bData & 0x40) ? ink : paper;
-                pFrame[4]  = pFrame[5]  = (bData & 0x20) ? ink : paper;
-                pFrame[6]  = pFrame[7]  = (bData & 0x10) ? ink : paper;
-                pFrame[8]  = pFrame[9]  = (bData & 0x08) ? ink : paper;
-                pFrame[10] = pFrame[11] = (bData & 0x04) ? ink : paper;
-                pFrame[12] = pFrame[13] = (bData & 0x02) ? ink : paper;
-                pFrame[14] = pFrame[15] = (bData & 0x01) ? ink : paper;
-            }
-
+            AttrBlock(pFrame, *pbDataMem++, *pbAttrMem++);
             pFrame += fHiRes_ ? 16 : 8;
         }
     }
@@ -544,7 +526,7 @@ void CFrameXx1<fHiRes_>::ScreenChange (BYTE *pbLine_, int nLine_, int nBlock_, B
                  pFrame[1]  = pFrame[2]  = pFrame[3]  =
     pFrame[4]  = pFrame[5]  = pFrame[6]  = pFrame[7]  =
     pFrame[8]  = pFrame[9]  = pFrame[10] = pFrame[11] =
-    pFrame[12] = pFrame[13] = pFrame[14] = pFrame[15] = clut[BORD_COL(bNewBorder_)];
+    pFrame[12] = pFrame[13] = pFrame[14] = pFrame[15] = clut[BORD_VAL(bNewBorder_)];
 }
 
 #endif  // FRAME_H
@@ -49,6 +49,7 @@
 #include "SDIDE.h"
 #include "SID.h"
 #include "Sound.h"
+#include "State.h"
 #include "Tape.h"
 #include "Util.h"
 #include "Video.h"
@@ -660,7 +661,9 @@ void IO::Out (WORD wPort_, BYTE bVal_)
         // Banked memory management
         case VMPR_PORT:
         {
-            // Changes to screen mode and screen page are visible at different times
+            // Changes to screen mode and screen page are visible at different times.
+            // Both change which memory writes are checked against the display, so
+            // they're drawn up to straight away rather than logged for later
 
             // Has the screen mode changed?
             if (vmpr_mode != (bVal_ & VMPR_MODE_MASK))
@@ -669,7 +672,7 @@ void IO::Out (WORD wPort_, BYTE bVal_)
                 if ((bVal_ | vmpr) & VMPR_MDE1_MASK)
                 {
                     // Changes to the screen MODE are visible straight away
-                    Frame::Update();
+                    Frame::Update(false);
 
                     // Change only the screen MODE for the transition block
                     OutVmpr((bVal_ & VMPR_MODE_MASK) | (vmpr & ~VMPR_MODE_MASK));
@@ -679,7 +682,7 @@ void IO::Out (WORD wPort_, BYTE bVal_)
                 {
                     // There are no visible changes in the transition block
                     g_dwCycleCounter += VIDEO_DELAY;
-                    Frame::Update();
+                    Frame::Update(false);
                     g_dwCycleCounter -= VIDEO_DELAY;
 
                     // Do the whole change here - the check below will not be triggered
@@ -696,7 +699,7 @@ void IO::Out (WORD wPort_, BYTE bVal_)
                 // Changes to screen PAGE aren't visible until 8 tstates later
                 // as the memory has been read by the ASIC already
                 g_dwCycleCounter += VIDEO_DELAY;
-                Frame::Update();
+                Frame::Update(false);
                 g_dwCycleCounter -= VIDEO_DELAY;
 
                 OutVmpr(bVal_);
@@ -1088,3 +1091,52 @@ bool IO::Rst48Hook ()
     // Continue with RST
     return false;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Save or restore the ASIC registers and the state of the stateful devices
+void IO::Serialize (CState &state_)
+{
+    state_.Value(vmpr);
+    state_.Value(hmpr);
+    state_.Value(lmpr);
+    state_.Value(lepr);
+    state_.Value(hepr);
+    state_.Value(vmpr_mode);
+    state_.Value(vmpr_page1);
+    state_.Value(vmpr_page2);
+    state_.Value(border);
+    state_.Value(border_col);
+    state_.Value(keyboard);
+    state_.Value(status_reg);
+    state_.Value(line_int);
+    state_.Value(lpen);
+    state_.Value(attr);
+    state_.Value(clut);
+    state_.Value(keyports);
+    state_.Value(keybuffer);
+    state_.Value(fASICStartup);
+    state_.Value(wPortRead);
+    state_.Value(wPortWrite);
+    state_.Value(bPortInVal);
+    state_.Value(bPortOutVal);
+
+    pDAC->Serialize(state_);
+    pSAA->Serialize(state_);
+    pFloppy1->Serialize(state_);
+    pFloppy2->Serialize(state_);
+    pDallas->Serialize(state_);
+    pMouse->Serialize(state_);
+    pBlueAlpha->Serialize(state_);
+    pMidi->Serialize(state_);
+
+    // SAMVox and Paula write straight to the DAC, so have no state of their own
+
+    if (state_.IsLoading())
+    {
+        // Rebuild the values derived from the registers
+        PaletteChange(hmpr);
+        UpdatePaging();
+        CPU::UpdateContention();
+    }
+}
@@ -29,6 +29,8 @@ typedef struct {
 
 enum { AUTOLOAD_NONE, AUTOLOAD_DISK, AUTOLOAD_TAPE };
 
+class CState;
+
 
 class IO
 {
@@ -56,6 +58,8 @@ class IO
         static bool EiHook ();
         static bool Rst8Hook ();
         static bool Rst48Hook ();
+
+        static void Serialize (CState &state_);
 };
 
 
@@ -74,6 +78,8 @@ class CIoDevice
 
         virtual void LoadState (const char *pcszFile_) { }  // preserve basic state (such as NVRAM)
         virtual void SaveState (const char *pcszFile_) { }
+
+        virtual void Serialize (CState &state_) { }         // snapshot of running state
 };
 
 enum { drvNone, drvFloppy, drvAtom, drvAtomLite, drvSDIDE };
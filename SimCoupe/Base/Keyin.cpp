@@ -96,6 +96,13 @@ bool Keyin::Next ()
             return false;
     }
 
+    // Keep the display up-to-date if the writes fall on it
+    if (vmpr_page1 == 0)
+    {
+        write_to_screen_vmpr0(0x5c08);
+        write_to_screen_vmpr0(0x5c3b);
+    }
+
     // Simulate the key press
     PageWritePtr(0)[0x5c08-0x4000] = bKey;  // set key in LASTK
     PageWritePtr(0)[0x5c3b-0x4000] |= 0x20; // signal key available in FLAGS
@@ -27,6 +27,7 @@
 #include "Options.h"
 #include "OSD.h"
 #include "SAMROM.h"
+#include "State.h"
 #include "Stream.h"
 #include "Util.h"
 
@@ -41,7 +42,10 @@ int anWritePages[TOTAL_PAGES];
 
 // Page numbers present in each of the 4 sections in the 64K address range
 int anSectionPages[4];
-bool afSectionContended[4];
+const BYTE* apbSectionContention[4];     // Contention table for each section, or NULL if uncontended
+
+// Pages written to since the flags were last cleared, for rewind snapshots
+bool afDirtyPages[TOTAL_PAGES];
 
 // Array of pointers for memory to use when reading from or writing to each each section
 BYTE *apbSectionReadPtrs[4];
@@ -114,6 +118,17 @@ void Memory::UpdateRom ()
     fUpdateRom = true;
 }
 
+// Save or restore the contents of all writable memory pages
+void Memory::Serialize (CState &state_)
+{
+    for (int nPage = 0 ; nPage < SCRATCH_READ ; nPage++)
+    {
+        // Skip pages that are absent or read-only in the current configuration
+        if (anWritePages[nPage] == nPage)
+            state_.Data(state_.IsLoading() ? PageWritePtr(nPage) : PageReadPtr(nPage), MEM_PAGE_SIZE);
+    }
+}
+
 
 // Memory page description, for the debugger
 const char *PageDesc (int nPage_, bool fCompact_/*=false*/)
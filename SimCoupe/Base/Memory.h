@@ -33,6 +33,8 @@ class Memory
     public:
         static void UpdateConfig ();
         static void UpdateRom ();
+
+        static void Serialize (CState &state_);
 };
 
 
@@ -40,12 +42,14 @@ enum { INTMEM, EXTMEM=N_PAGES_MAIN, ROM0=EXTMEM+(N_PAGES_1MB*MAX_EXTERNAL_MB), R
 enum eSection { SECTION_A, SECTION_B, SECTION_C, SECTION_D };
 
 extern BYTE *pMemory;
+extern bool afDirtyPages[];
 
 extern int anReadPages[];
 extern int anWritePages[];
 
 extern int anSectionPages[4];
-extern bool afSectionContended[4];
+extern const BYTE* apbSectionContention[4];
+extern const BYTE* pContention;
 
 extern BYTE* apbSectionReadPtrs[4];
 extern BYTE* apbSectionWritePtrs[4];
@@ -65,9 +69,9 @@ inline UINT PageReadOffset (int nPage_) { return anReadPages[nPage_]*MEM_PAGE_SI
 inline UINT PageWriteOffset (int nPage_) { return anWritePages[nPage_]*MEM_PAGE_SIZE; }
 
 inline BYTE *PageReadPtr (int nPage_) { return pMemory + PageReadOffset(nPage_); }
-inline BYTE *PageWritePtr (int nPage_) { return pMemory + PageWriteOffset(nPage_); }
+inline BYTE *PageWritePtr (int nPage_) { afDirtyPages[anWritePages[nPage_]] = true; return pMemory + PageWriteOffset(nPage_); }
 inline BYTE *AddrReadPtr (WORD wAddr_) { return apbSectionReadPtrs[AddrSection(wAddr_)] + (wAddr_ & (MEM_PAGE_SIZE-1)); }
-inline BYTE *AddrWritePtr (WORD wAddr_) { return apbSectionWritePtrs[AddrSection(wAddr_)] + (wAddr_ & (MEM_PAGE_SIZE-1)); }
+inline BYTE *AddrWritePtr (WORD wAddr_) { afDirtyPages[AddrPage(wAddr_)] = true; return apbSectionWritePtrs[AddrSection(wAddr_)] + (wAddr_ & (MEM_PAGE_SIZE-1)); }
 inline int PtrPage (const void *pv_) { return int((reinterpret_cast<const BYTE*>(pv_)-pMemory)/MEM_PAGE_SIZE); }
 inline int PtrOffset (const void *pv_) { return int((reinterpret_cast<const BYTE*>(pv_)-pMemory) & (MEM_PAGE_SIZE-1)); }
 
@@ -119,7 +123,7 @@ inline void PageIn (eSection nSection_, int nPage_)
 {
     // Remember the page that's now occupying the section, and update the contention
     anSectionPages[nSection_] = nPage_;
-    afSectionContended[nSection_] = (nPage_ < N_PAGES_MAIN);
+    apbSectionContention[nSection_] = (nPage_ < N_PAGES_MAIN) ? pContention : NULL;
 
     // Set the memory read and write pointers
     apbSectionReadPtrs[nSection_] = PageReadPtr(nPage_);
@@ -28,6 +28,7 @@
 
 #include "CPU.h"
 #include "Options.h"
+#include "State.h"
 #include "Util.h"
 
 
@@ -93,6 +94,17 @@ BYTE CMouseDevice::In (WORD wPort_)
     return bRet;
 }
 
+// Save or restore the movement not yet read and the read position, leaving the host button state
+void CMouseDevice::Serialize (CState &state_)
+{
+    state_.Value(m_nDeltaX);
+    state_.Value(m_nDeltaY);
+    state_.Value(m_nReadX);
+    state_.Value(m_nReadY);
+    state_.Value(m_sMouse);
+    state_.Value(m_uBuffer);
+}
+
 
 // Move the mouse
 void CMouseDevice::Move (int nDeltaX_, int nDeltaY_)
@@ -46,6 +46,8 @@ class CMouseDevice : public CIoDevice
         void Reset ();
         BYTE In (WORD wPort_);
 
+        void Serialize (CState &state_);
+
     public:
         void Move (int nDeltaX_, int nDeltaY_);
         void SetButton (int nButton_, bool fPressed_=true);
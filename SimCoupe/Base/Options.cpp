@@ -66,6 +66,8 @@ OPTION aOptions[] =
     OPT_F("Scanlines",    scanlines,      false/*true*/),      // TV scanlines
     OPT_N("ScanLevel",    scanlevel,      80),        // Scanlines are 80% brightness
     OPT_F("ScanHiRes",    scanhires,      true),      // Scanlines at PC resolution (if supported)
+    OPT_N("OutScale",     outscale,       1),         // Output image isn't scaled
+    OPT_F("CrtMask",      crtmask,        false),     // No CRT mask
     OPT_N("Mode3",        mode3,          0),         // Show only odd mode3 pixels on low-res displays
     OPT_F("Fullscreen",   fullscreen,     false),     // Not full screen
     OPT_N("Borders",      borders,        2),         // Same amount of borders as previous version
@@ -74,6 +76,8 @@ OPTION aOptions[] =
     OPT_F("Filter",       filter,         true),      // Filter the image when stretching
     OPT_F("FilterGUI",    filtergui,      false),     // Don't filter the image when the GUI is active
     OPT_N("Direct3D",     direct3d,       -1),        // Automatic use of D3D (currently, Vista or later)
+    OPT_F("DirectVideo",  directvideo,    true),      // Convert lines to the display as they're drawn
+    OPT_F("DeferVideo",   defervideo,     true),      // Draw display register changes at the end of the frame
 
     OPT_N("AviReduce",    avireduce,      1),         // Record 44kHz 8-bit stereo audio (50% saving)
     OPT_F("AviScanlines", aviscanlines,   false),     // Don't include scanlines in AVI recordings
@@ -87,6 +91,7 @@ OPTION aOptions[] =
     OPT_N("ExternalMem",  externalmem,    0),         // No external memory
     OPT_F("NMOSZ80",      nmosz80,        1),         // NMOS rather than CMOS Z80?
     OPT_N("Speed",        speed,          100),       // Default to 100% speed
+    OPT_N("Rewind",       rewind,         0),         // No rewind history (opt-in, in MB)
 
     OPT_N("Drive1",       drive1,         1),         // Floppy drive 1 present
     OPT_N("Drive2",       drive2,         1),         // Floppy drive 2 present
@@ -153,13 +158,19 @@ OPTION aOptions[] =
     OPT_N("DAC7C",        dac7c,          1),         // Blue Alpha Sampler on port &7c
     OPT_N("SamplerFreq",  samplerfreq,    18000),     // Blue Alpha clock frequency (default=18KHz)
     OPT_N("SID",          sid,            1),         // SID interface with MOS6581
+    OPT_F("SAABlip",      saablip,        false),     // SAA output ticked per sample, rather than band-limited
+    OPT_N("DACVolume",    dacvolume,      100),       // DAC mixed at full level
+    OPT_N("SAAVolume",    saavolume,      100),       // SAA mixed at full level
+    OPT_N("SIDVolume",    sidvolume,      100),       // SID mixed at full level
+    OPT_N("OutputFreq",   outputfreq,     44100),     // Output at the emulated sample rate
+    OPT_N("Resampler",    resampler,      1),         // Windowed-sinc resampling
 
     OPT_N("DriveLights",  drivelights,    1),         // Show drive activity lights
     OPT_F("Profile",      profile,        true),      // Show only emulation speed and framerate
     OPT_F("Status",       status,         true),      // Show status line for changed options, etc.
 
     OPT_S("FnKeys",       fnkeys,
-     "F1=1,SF1=2,AF1=0,CF1=3,F2=5,SF2=6,AF2=4,CF2=7,F3=30,F4=11,SF4=12,AF4=8,F5=25,SF5=23,F6=26,F7=21,F8=22,F9=14,SF9=13,F10=9,SF10=10,F11=16,F12=15,CF12=8"),
+     "F1=1,SF1=2,AF1=0,CF1=3,F2=5,SF2=6,AF2=4,CF2=7,F3=30,F4=11,SF4=12,AF4=8,F5=25,SF5=23,F6=26,F7=21,F8=22,F9=14,SF9=13,F10=9,SF10=10,F11=16,SF11=51,F12=15,CF12=8"),
     OPT_S("KeyMap",       keymap,         "76,68,65,66,48,16,17,56,56"),  // Pocket PC keymap: left,right,up,down,enter,q,w,space,space
 
     { NULL, 0 }
@@ -34,6 +34,8 @@ typedef struct
     bool    scanlines;              // Show scanlines?
     int     scanlevel;              // Scanline brightness level
     bool    scanhires;              // Hi-res scanlines at native display resolution?
+    int     outscale;               // Integer scaling of the output image
+    bool    crtmask;                // Apply a CRT aperture grille mask to the output?
     int     mode3;                  // Which mode3 pixels to show on low-res displays?
     bool    fullscreen;             // Start in full-screen mode?
     int     borders;                // How much of the borders to show
@@ -42,6 +44,8 @@ typedef struct
     bool    filter;                 // Filter image when stretching? (if available)
     bool    filtergui;              // Filter image when the GUI is active? (if available)
     int     direct3d;               // Use Direct3D? <0=auto, 0=disable, >0=enable
+    bool    directvideo;            // Convert lines to the display format as they're drawn? (if available)
+    bool    defervideo;             // Log display register changes and draw the frame at the end?
 
     int     avireduce;              // Reduce AVI audio size (0=lossless to 4=muted)
     bool    aviscanlines;           // Include scanlines in AVI recording?
@@ -55,6 +59,7 @@ typedef struct
     int     externalmem;            // Number of MB of external memory
     bool    nmosz80;                // NMOS rather than CMOS Z80?
     int     speed;                  // Running speed (percentage)
+    int     rewind;                 // Rewind buffer size in MB (0=disabled)
 
     int     drive1;                 // Drive 1 type
     int     drive2;                 // Drive 2 type
@@ -123,6 +128,12 @@ typedef struct
     int     dac7c;                  // DAC device on shared port &7c? (0=none, 1=BlueAlpha Sampler, 2=SAMVox, 3=Paula)
     int     samplerfreq;            // Blue Alpha Sampler clock frequency
     int     sid;                    // SID chip type (0=none, 1=MOS6581, 2=MOS8580)
+    bool    saablip;                // Generate SAA output from its edges, band-limited?
+    int     dacvolume;              // DAC mix level, as a percentage (0=muted)
+    int     saavolume;              // SAA mix level
+    int     sidvolume;              // SID mix level
+    int     outputfreq;             // Output sample rate, resampled from the emulated rate
+    int     resampler;              // Resampler type (0=linear, 1=windowed-sinc)
 
     int     drivelights;            // Show floppy drive LEDs
     bool    profile;                // Show profile stats?
@@ -0,0 +1,106 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// Profile.cpp: Per-subsystem timing for benchmarks
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Notes:
+//
+//  Sections may nest, such as a frame update triggered by a CPU write to
+//  display memory.  Time is only charged to the innermost active section,
+//  so each total excludes the time spent in the others.
+
+#include "SimCoupe.h"
+#include "Profile.h"
+
+#ifdef RETRO
+extern "C" long GetTicks();     // microseconds
+#endif
+
+const int MAX_PROFILE_DEPTH = 8;
+
+bool Profile::s_fEnabled;
+
+static unsigned long aulTime[PROF_SECTIONS];    // Accumulated time in microseconds
+static int anStack[MAX_PROFILE_DEPTH], nDepth;
+static long lLastTime;
+
+static const char* aszNames[PROF_SECTIONS] = { "CPU", "Frame::Update", "SAA generate", "Flip" };
+
+////////////////////////////////////////////////////////////////////////////////
+
+static long GetMicroTime ()
+{
+#ifdef RETRO
+    return GetTicks();
+#else
+    return static_cast<long>(OSD::GetTime()) * 1000;
+#endif
+}
+
+
+void Profile::Enable (bool fEnable_)
+{
+    s_fEnabled = fEnable_;
+    nDepth = 0;
+}
+
+void Profile::Reset ()
+{
+    memset(aulTime, 0, sizeof(aulTime));
+    nDepth = 0;
+}
+
+
+void Profile::Start (int nSection_)
+{
+    long lNow = GetMicroTime();
+
+    // Charge the time so far to the section we're interrupting
+    if (nDepth)
+        aulTime[anStack[min(nDepth, MAX_PROFILE_DEPTH)-1]] += lNow - lLastTime;
+
+    // Sections nested deeper than we track are charged to the deepest one we do
+    if (nDepth < MAX_PROFILE_DEPTH)
+        anStack[nDepth] = nSection_;
+
+    nDepth++;
+    lLastTime = lNow;
+}
+
+void Profile::Stop ()
+{
+    // Ignore sections started before profiling was enabled
+    if (!nDepth)
+        return;
+
+    long lNow = GetMicroTime();
+    nDepth--;
+    aulTime[anStack[min(nDepth, MAX_PROFILE_DEPTH-1)]] += lNow - lLastTime;
+    lLastTime = lNow;
+}
+
+
+unsigned long Profile::GetTime (int nSection_)
+{
+    return aulTime[nSection_];
+}
+
+const char* Profile::GetName (int nSection_)
+{
+    return aszNames[nSection_];
+}
@@ -0,0 +1,50 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// Profile.h: Per-subsystem timing for benchmarks
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+enum { PROF_CPU, PROF_FRAME, PROF_SOUND, PROF_FLIP, PROF_SECTIONS };
+
+class Profile
+{
+    public:
+        static void Enable (bool fEnable_);
+        static void Reset ();
+
+        static void Start (int nSection_);
+        static void Stop ();
+
+        static unsigned long GetTime (int nSection_);
+        static const char* GetName (int nSection_);
+
+    public:
+        static bool s_fEnabled;
+};
+
+// Times the enclosing scope against a section, when profiling is enabled
+class CProfileSection
+{
+    public:
+        CProfileSection (int nSection_) { if (Profile::s_fEnabled) Profile::Start(nSection_); }
+        ~CProfileSection () { if (Profile::s_fEnabled) Profile::Stop(); }
+};
+
+#endif  // PROFILE_H
@@ -0,0 +1,217 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// Resample.cpp: Sample rate conversion for sound output
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Notes:
+//
+//  Output sample k is taken at input position m_qPos, using the m_nTaps input
+//  samples around it, weighted by the coefficients for the phase of its
+//  fractional part.  Each phase sums to exactly 1.0, and the sinc cutoff is
+//  only lowered below the input Nyquist rate when decimating, so a 1:1 ratio
+//  passes samples through unchanged, just m_nTaps/2 samples later.
+//
+//  Speed changes scale the step, so slower speeds stretch the audio rather
+//  than repeating samples, and faster ones filter it before dropping any.
+
+#include <math.h>
+
+#include "SimCoupe.h"
+#include "Resample.h"
+
+const double PI = 3.14159265358979323846;
+const int RESAMPLE_PHASES = 1 << RESAMPLE_PHASE_BITS;
+
+//////////////////////////////////////////////////////////////////////////////
+
+CResampler::CResampler (int nMaxFrames_)
+    : m_nMaxFrames(nMaxFrames_), m_nInRate(0), m_nOutRate(0), m_nSpeed(0), m_fSinc(false), m_nAdjust(0),
+      m_nTaps(0), m_psFilter(NULL), m_psOut(NULL), m_nOutSize(0)
+{
+    m_psFilter = new short[RESAMPLE_PHASES * RESAMPLE_MAX_TAPS];
+    m_psWork = new short[(RESAMPLE_MAX_TAPS + m_nMaxFrames) * 2];
+}
+
+CResampler::~CResampler ()
+{
+    delete[] m_psFilter;
+    delete[] m_psWork;
+    delete[] m_psOut;
+}
+
+
+// Set the conversion, rebuilding the filter if anything has changed
+void CResampler::Configure (int nInRate_, int nOutRate_, int nSpeed_, bool fSinc_)
+{
+    if (nInRate_ == m_nInRate && nOutRate_ == m_nOutRate && nSpeed_ == m_nSpeed && fSinc_ == m_fSinc)
+        return;
+
+    m_nInRate = nInRate_;
+    m_nOutRate = nOutRate_;
+    m_nSpeed = nSpeed_;
+
+    // A different filter length changes the delay, so start afresh
+    int nTaps = m_nTaps;
+    m_fSinc = fSinc_;
+    BuildFilter();
+
+    if (m_nTaps != nTaps)
+        Reset();
+
+    UpdateStep();
+}
+
+// Set a small rate adjustment, for the output to follow the host clock
+void CResampler::SetAdjust (int nPPM_)
+{
+    nPPM_ = max(nPPM_, -RESAMPLE_MAX_ADJUST);
+    nPPM_ = min(nPPM_, RESAMPLE_MAX_ADJUST);
+
+    if (nPPM_ != m_nAdjust)
+    {
+        m_nAdjust = nPPM_;
+        UpdateStep();
+    }
+}
+
+// Discard any carried over input, with silence leading up to the next frame
+void CResampler::Reset ()
+{
+    m_nKept = m_nTaps/2 - 1;
+    memset(m_psWork, 0x00, m_nKept * 2 * sizeof(*m_psWork));
+    m_qPos = static_cast<ULONGLONG>(m_nKept) << 32;
+}
+
+
+// Convert a frame, returning the output samples and their count
+short *CResampler::Process (const short *psIn_, int nFrames_, int &nOut_)
+{
+    // Append the new samples to those still needed from the last frame
+    memcpy(m_psWork + m_nKept*2, psIn_, nFrames_ * 2 * sizeof(*psIn_));
+    int nTotal = m_nKept + nFrames_;
+
+    int nHalf = m_nTaps/2;
+    int nPhaseShift = 32 - RESAMPLE_PHASE_BITS;
+    ULONGLONG qPos = m_qPos;
+    short *pd = m_psOut;
+    int i;
+
+    // Generate while all the taps for the next sample are available
+    for (nOut_ = 0 ; (i = static_cast<int>(qPos >> 32)) + nHalf < nTotal && nOut_ < m_nOutSize ; nOut_++, qPos += m_qStep)
+    {
+        const short *ps = m_psWork + (i - nHalf + 1) * 2;
+        const short *pc = m_psFilter + (static_cast<int>(qPos >> nPhaseShift) & (RESAMPLE_PHASES-1)) * m_nTaps;
+        int nLeft = 0, nRight = 0;
+
+        for (int j = 0 ; j < m_nTaps ; j++, ps += 2)
+        {
+            nLeft += ps[0] * pc[j];
+            nRight += ps[1] * pc[j];
+        }
+
+        // Round, and clip any overshoot near full level
+        nLeft = (nLeft + (1 << 13)) >> 14;
+        nRight = (nRight + (1 << 13)) >> 14;
+        *pd++ = static_cast<short>(nLeft < -32768 ? -32768 : nLeft > 32767 ? 32767 : nLeft);
+        *pd++ = static_cast<short>(nRight < -32768 ? -32768 : nRight > 32767 ? 32767 : nRight);
+    }
+
+    // Keep the samples from the first tap of the next output, or none if it's beyond this frame
+    int nFirst = min(static_cast<int>(qPos >> 32) - nHalf + 1, nTotal);
+    m_nKept = nTotal - nFirst;
+    memmove(m_psWork, m_psWork + nFirst*2, m_nKept * 2 * sizeof(*m_psWork));
+    m_qPos = qPos - (static_cast<ULONGLONG>(nFirst) << 32);
+
+    return m_psOut;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void CResampler::BuildFilter ()
+{
+    // Input samples consumed per output sample, at the nominal rate
+    double dRatio = static_cast<double>(m_nInRate) * m_nSpeed / (static_cast<double>(m_nOutRate) * 100);
+
+    if (!m_fSinc)
+    {
+        // Linear interpolation between the 2 nearest samples
+        m_nTaps = 2;
+
+        for (int p = 0 ; p < RESAMPLE_PHASES ; p++)
+        {
+            int nFrac = (p << 14) >> RESAMPLE_PHASE_BITS;
+            m_psFilter[p*2] = static_cast<short>((1 << 14) - nFrac);
+            m_psFilter[p*2+1] = static_cast<short>(nFrac);
+        }
+
+        return;
+    }
+
+    // When decimating, lower the cutoff to the output Nyquist rate and widen the filter to match
+    double dCutoff = (dRatio > 1.0) ? 1.0 / dRatio : 1.0;
+    m_nTaps = min(RESAMPLE_TAPS * static_cast<int>(ceil(dRatio)), RESAMPLE_MAX_TAPS);
+
+    int nHalf = m_nTaps/2;
+
+    for (int p = 0 ; p < RESAMPLE_PHASES ; p++)
+    {
+        short *pc = m_psFilter + p*m_nTaps;
+        double adTaps[RESAMPLE_MAX_TAPS], dSum = 0.0;
+        double dFrac = static_cast<double>(p) / RESAMPLE_PHASES;
+
+        for (int j = 0 ; j < m_nTaps ; j++)
+        {
+            // Distance from the output position, with a Blackman window over the filter length
+            double d = dFrac + nHalf - 1 - j;
+            double x = PI * d * dCutoff;
+            double w = (d + nHalf) / m_nTaps;
+            double dWindow = 0.42 - 0.5*cos(2*PI*w) + 0.08*cos(4*PI*w);
+
+            adTaps[j] = ((d == 0.0) ? 1.0 : sin(x) / x) * dWindow;
+            dSum += adTaps[j];
+        }
+
+        // Scale so each phase sums to exactly 1.0, with any rounding error in the largest tap
+        int nTotal = 0, nLargest = nHalf - 1 + (p >= RESAMPLE_PHASES/2);
+
+        for (int j = 0 ; j < m_nTaps ; j++)
+        {
+            pc[j] = static_cast<short>(floor(adTaps[j] * (1 << 14) / dSum + 0.5));
+            nTotal += pc[j];
+        }
+
+        pc[nLargest] += static_cast<short>((1 << 14) - nTotal);
+    }
+}
+
+void CResampler::UpdateStep ()
+{
+    // Input samples per output sample, including any speed change and adjustment, in 32.32 fixed point
+    double dStep = static_cast<double>(m_nInRate) * m_nSpeed * (1000000 + m_nAdjust) / (static_cast<double>(m_nOutRate) * 100 * 1000000);
+    m_qStep = static_cast<ULONGLONG>(dStep * 4294967296.0 + 0.5);
+
+    // Size the output for the most a frame can give at this step, including carried over input
+    int nSize = static_cast<int>((m_nMaxFrames + RESAMPLE_MAX_TAPS) / dStep) + 2;
+
+    if (nSize > m_nOutSize)
+    {
+        delete[] m_psOut;
+        m_psOut = new short[nSize * 2];
+        m_nOutSize = nSize;
+    }
+}
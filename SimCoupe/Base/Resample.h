@@ -0,0 +1,68 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// Resample.h: Sample rate conversion for sound output
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#define RESAMPLE_PHASE_BITS     9       // 512 filter phases between input samples
+#define RESAMPLE_TAPS           16      // windowed-sinc length for conversion without decimation
+#define RESAMPLE_MAX_TAPS       64      // longest filter, used when decimating for high speeds
+#define RESAMPLE_MAX_ADJUST     5000    // largest rate adjustment, in parts per million
+
+
+// Converts frames of interleaved 16-bit stereo samples to another rate using a
+// polyphase filter, which is either a windowed-sinc or a 2-tap linear ramp.
+// The step between output samples is kept in 32.32 fixed point, so the ratio
+// can be changed between frames without breaking the continuity of the output.
+class CResampler
+{
+    public:
+        CResampler (int nMaxFrames_);
+        ~CResampler ();
+
+    public:
+        void Configure (int nInRate_, int nOutRate_, int nSpeed_, bool fSinc_);
+        void SetAdjust (int nPPM_);
+        void Reset ();
+
+        short *Process (const short *psIn_, int nFrames_, int &nOut_);
+
+    protected:
+        void BuildFilter ();
+        void UpdateStep ();
+
+    protected:
+        int m_nMaxFrames;           // largest input frame
+        int m_nInRate, m_nOutRate, m_nSpeed;
+        bool m_fSinc;
+        int m_nAdjust;              // rate adjustment in parts per million
+
+        int m_nTaps;                // filter length, in input samples
+        short *m_psFilter;          // coefficients for each phase, in 2.14 fixed point
+
+        short *m_psWork;            // input carried over from the last frame, followed by the new one
+        int m_nKept;
+        ULONGLONG m_qPos, m_qStep;  // position of the next output sample in m_psWork, and the step between them
+
+        short *m_psOut;
+        int m_nOutSize;             // output buffer size, in samples
+};
+
+#endif  // RESAMPLE_H
@@ -0,0 +1,357 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// Rewind.cpp: Rewind history of delta-compressed snapshots
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Notes:
+//
+//  A full copy of memory and machine state is kept as it was at the newest
+//  entry.  Each frame the pages written since (tracked by the memory write
+//  functions) are XORed against that copy and run-length encoded, along with
+//  the machine state, to form the next entry.  As XOR is its own inverse, the
+//  same entry applied to the copy steps it back to the previous frame.
+//
+//  Entries are stored in a fixed-size byte ring, with the oldest discarded to
+//  make space for new ones.
+
+#include "SimCoupe.h"
+#include "Rewind.h"
+
+#include "CPU.h"
+#include "Memory.h"
+#include "Options.h"
+#include "State.h"
+
+const int MAX_REWIND_ENTRIES = 1 << 14;     // Up to ~5 minutes at 50fps, if the buffer is big enough
+
+typedef struct
+{
+    size_t uOffset, uSize;
+}
+REWIND_ENTRY;
+
+static BYTE *pbRing, *pbScratch;        // Entry ring buffer, and working space to build a new entry
+static size_t uRingSize, uWrite;        // Ring size and offset for the next entry
+
+static REWIND_ENTRY asEntries[MAX_REWIND_ENTRIES];
+static int nOldest, nEntries;
+
+static int anPages[TOTAL_PAGES], nPages;    // Pages captured, in shadow order
+static BYTE *pbShadow;                  // Memory pages as of the newest entry
+
+static BYTE *pbMachine, *pbMachineRef;  // Machine state now, and as of the newest entry
+static size_t uMachineSize;
+
+static int anConfig[3];                 // Settings the buffers were allocated for
+static bool fActive;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Rewind::Exit (bool fReInit_/*=false*/)
+{
+    // Keep the history over a reset, in case it's rewound
+    if (fReInit_)
+        return;
+
+    delete[] pbRing, pbRing = NULL;
+    delete[] pbScratch, pbScratch = NULL;
+    delete[] pbShadow, pbShadow = NULL;
+    delete[] pbMachine, pbMachine = NULL;
+    delete[] pbMachineRef, pbMachineRef = NULL;
+
+    nEntries = 0;
+}
+
+
+void Rewind::SetActive (bool fActive_)
+{
+    fActive = fActive_;
+}
+
+bool Rewind::IsActive ()
+{
+    return fActive;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Encode the XOR difference from the reference data as alternating runs of unchanged and
+// changed bytes, updating the reference to match.  Returns the encoded size, or 0 if full.
+static size_t Encode (BYTE *pbDst_, size_t uSpace_, const BYTE *pbNew_, BYTE *pbRef_, size_t uLen_)
+{
+    BYTE *pb = pbDst_;
+    size_t i = 0;
+
+    while (i < uLen_)
+    {
+        // Skip unchanged data, 8 bytes at a time where possible
+        size_t uStart = i, uMax = min(uLen_, uStart+0xffff);
+        while (i+8 <= uMax && !memcmp(pbNew_+i, pbRef_+i, 8))
+            i += 8;
+        while (i < uMax && pbNew_[i] == pbRef_[i])
+            i++;
+
+        WORD wSame = static_cast<WORD>(i - uStart);
+
+        // Gather changed data, ending the run at 4 unchanged bytes in a row
+        uStart = i, uMax = min(uLen_, uStart+0xfff0);
+        while (i < uMax)
+        {
+            size_t j = i;
+            while (j < uLen_ && j-i < 4 && pbNew_[j] == pbRef_[j])
+                j++;
+
+            if (j-i == 4 || j == uLen_)
+                break;
+
+            i = j+1;
+        }
+
+        WORD wDiff = static_cast<WORD>(i - uStart);
+
+        // Check there's space for the run header and data
+        if (static_cast<size_t>(pb - pbDst_) + sizeof(WORD)*2 + wDiff > uSpace_)
+            return 0;
+
+        memcpy(pb, &wSame, sizeof(wSame)); pb += sizeof(wSame);
+        memcpy(pb, &wDiff, sizeof(wDiff)); pb += sizeof(wDiff);
+
+        for (size_t n = uStart ; n < i ; n++)
+        {
+            *pb++ = pbNew_[n] ^ pbRef_[n];
+            pbRef_[n] = pbNew_[n];
+        }
+    }
+
+    return pb - pbDst_;
+}
+
+// Apply an encoded XOR difference to the reference data, returning the end of the encoded data
+static const BYTE *Decode (const BYTE *pbSrc_, BYTE *pbRef_, size_t uLen_)
+{
+    for (size_t i = 0 ; i < uLen_ ; )
+    {
+        WORD wSame, wDiff;
+        memcpy(&wSame, pbSrc_, sizeof(wSame)); pbSrc_ += sizeof(wSame);
+        memcpy(&wDiff, pbSrc_, sizeof(wDiff)); pbSrc_ += sizeof(wDiff);
+
+        for (i += wSame ; wDiff-- ; )
+            pbRef_[i++] ^= *pbSrc_++;
+    }
+
+    return pbSrc_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Discard all entries and take the current state as the new reference point
+static void Restart ()
+{
+    for (int i = 0 ; i < nPages ; i++)
+        memcpy(pbShadow + i*MEM_PAGE_SIZE, PageReadPtr(anPages[i]), MEM_PAGE_SIZE);
+
+    CState state(pbMachineRef, uMachineSize, false);
+    State::SerializeMachine(state);
+
+    memset(afDirtyPages, 0, sizeof(afDirtyPages[0])*TOTAL_PAGES);
+    nOldest = nEntries = 0;
+    uWrite = 0;
+}
+
+// Allocate the buffers for the current settings, returning false if rewind is disabled
+static bool Configure ()
+{
+    int anNow[] = { GetOption(rewind), GetOption(mainmem), GetOption(externalmem) };
+
+    // Nothing to do if the settings are unchanged since we allocated
+    if (pbRing && !memcmp(anNow, anConfig, sizeof(anConfig)))
+        return true;
+
+    Rewind::Exit();
+    memcpy(anConfig, anNow, sizeof(anConfig));
+
+    if (GetOption(rewind) <= 0)
+        return false;
+
+    // Capture the writable RAM pages.  ROM is left alone even if writable, as ROM
+    // reloads on reset don't set the dirty flags and the shadow copy would go stale
+    for (int nPage = nPages = 0 ; nPage < ROM0 ; nPage++)
+    {
+        if (anWritePages[nPage] == nPage)
+            anPages[nPages++] = nPage;
+    }
+
+    CState state;
+    State::SerializeMachine(state);
+    uMachineSize = state.GetSize();
+
+    uRingSize = static_cast<size_t>(GetOption(rewind)) << 20;
+    pbRing = new BYTE[uRingSize];
+    pbScratch = new BYTE[uRingSize];
+    pbShadow = new BYTE[nPages*MEM_PAGE_SIZE];
+    pbMachine = new BYTE[uMachineSize];
+    pbMachineRef = new BYTE[uMachineSize];
+
+    Restart();
+    return false;
+}
+
+// Drop the oldest entry
+static void DropOldest ()
+{
+    nOldest = (nOldest+1) % MAX_REWIND_ENTRIES;
+    nEntries--;
+}
+
+// Add a completed entry to the ring, discarding old entries to make space
+static void Store (const BYTE *pb_, size_t uSize_)
+{
+    if (uSize_ > uRingSize)
+    {
+        Restart();
+        return;
+    }
+
+    // Wrap to the start if there's not enough space at the end
+    if (uWrite + uSize_ > uRingSize)
+    {
+        // Anything left above the write position is from the previous pass, so older
+        while (nEntries && asEntries[nOldest].uOffset >= uWrite)
+            DropOldest();
+
+        uWrite = 0;
+    }
+
+    // Drop entries overlapping the space needed
+    while (nEntries && asEntries[nOldest].uOffset < uWrite+uSize_ &&
+           asEntries[nOldest].uOffset+asEntries[nOldest].uSize > uWrite)
+        DropOldest();
+
+    if (nEntries == MAX_REWIND_ENTRIES)
+        DropOldest();
+
+    memcpy(pbRing+uWrite, pb_, uSize_);
+
+    REWIND_ENTRY *pEntry = &asEntries[(nOldest+nEntries++) % MAX_REWIND_ENTRIES];
+    pEntry->uOffset = uWrite;
+    pEntry->uSize = uSize_;
+
+    uWrite += uSize_;
+}
+
+
+// Record the changes made during the frame that just ended
+void Rewind::FrameEnd ()
+{
+    // No recording while we're stepping back through the history
+    if (fActive || !Configure())
+        return;
+
+    BYTE *pb = pbScratch, *pbEnd = pbScratch + uRingSize;
+    WORD wPages = 0;
+    size_t uLen;
+
+    // Entry starts with the changed page count, filled in at the end
+    pb += sizeof(wPages);
+
+    CState state(pbMachine, uMachineSize, false);
+    State::SerializeMachine(state);
+
+    if (!(uLen = Encode(pb, pbEnd-pb, pbMachine, pbMachineRef, uMachineSize)))
+    {
+        Restart();
+        return;
+    }
+
+    pb += uLen;
+
+    for (int i = 0 ; i < nPages ; i++)
+    {
+        int nPage = anPages[i];
+
+        if (!afDirtyPages[nPage])
+            continue;
+
+        afDirtyPages[nPage] = false;
+
+        // Page index followed by its changes
+        WORD wIndex = static_cast<WORD>(i);
+        if (pbEnd-pb < static_cast<int>(sizeof(wIndex)) ||
+            !(uLen = Encode(pb+sizeof(wIndex), pbEnd-pb-sizeof(wIndex), PageReadPtr(nPage), pbShadow + i*MEM_PAGE_SIZE, MEM_PAGE_SIZE)))
+        {
+            Restart();
+            return;
+        }
+
+        // Skip pages written with the same data, which encode as a single unchanged run
+        if (uLen == sizeof(WORD)*2 && !memcmp(pb+sizeof(wIndex)+sizeof(WORD), "\0\0", sizeof(WORD)))
+            continue;
+
+        memcpy(pb, &wIndex, sizeof(wIndex));
+        pb += sizeof(wIndex) + uLen;
+        wPages++;
+    }
+
+    memcpy(pbScratch, &wPages, sizeof(wPages));
+    Store(pbScratch, pb - pbScratch);
+}
+
+// Step back to the state at the previous frame end
+bool Rewind::Step ()
+{
+    if (!pbRing || !nEntries)
+        return false;
+
+    // Undo anything written since the newest entry was recorded
+    for (int i = 0 ; i < nPages ; i++)
+    {
+        if (afDirtyPages[anPages[i]])
+            memcpy(pMemory + PageWriteOffset(anPages[i]), pbShadow + i*MEM_PAGE_SIZE, MEM_PAGE_SIZE);
+    }
+
+    // Take the newest entry, reclaiming its space
+    const REWIND_ENTRY *pEntry = &asEntries[(nOldest + --nEntries) % MAX_REWIND_ENTRIES];
+    const BYTE *pb = pbRing + pEntry->uOffset;
+    uWrite = pEntry->uOffset;
+
+    WORD wPages;
+    memcpy(&wPages, pb, sizeof(wPages));
+    pb += sizeof(wPages);
+
+    pb = Decode(pb, pbMachineRef, uMachineSize);
+
+    while (wPages--)
+    {
+        WORD wIndex;
+        memcpy(&wIndex, pb, sizeof(wIndex));
+        pb += sizeof(wIndex);
+
+        BYTE *pbPage = pbShadow + wIndex*MEM_PAGE_SIZE;
+        pb = Decode(pb, pbPage, MEM_PAGE_SIZE);
+        memcpy(pMemory + PageWriteOffset(anPages[wIndex]), pbPage, MEM_PAGE_SIZE);
+    }
+
+    // Restore the machine state from a copy, as loading doesn't modify the source
+    memcpy(pbMachine, pbMachineRef, uMachineSize);
+    CState state(pbMachine, uMachineSize, true);
+    State::SerializeMachine(state);
+
+    // Memory now matches the shadow copy
+    memset(afDirtyPages, 0, sizeof(afDirtyPages[0])*TOTAL_PAGES);
+    return true;
+}
@@ -0,0 +1,36 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// Rewind.h: Rewind history of delta-compressed snapshots
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef REWIND_H
+#define REWIND_H
+
+class Rewind
+{
+    public:
+        static void Exit (bool fReInit_=false);
+
+        static void FrameEnd ();
+        static bool Step ();
+
+        static void SetActive (bool fActive_);
+        static bool IsActive ();
+};
+
+#endif  // REWIND_H
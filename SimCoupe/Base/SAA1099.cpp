@@ -37,10 +37,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // - removed export wrapper to expose implementation class
 // - removed parameter config, leaving 16-bit stereo samples only
 // - caller-supplied output frequency, rather than fixed 44.1KHz
+// - added Serialize() to save and restore the chip state for snapshots
+// - added IsSilent() so callers can skip generating output that's known to be zero
 
 #include "SimCoupe.h"
 
 #include "SAA1099.h"
+#include "State.h"
 
 //////////////////////////////////////////////////////////////////////
 // CSAAAmp: tone and noise mixing, envelope application and amplification
@@ -179,6 +182,19 @@ void CSAAAmp::Mute(bool bMute)
 	m_bMute = bMute;
 }
 
+bool CSAAAmp::IsSilent() const
+{
+	// output is zero if muted, or with zero level (bits used by the envelope only),
+	// or when neither tone nor noise is mixed in without an envelope
+	if (m_bMute)
+		return true;
+
+	if (m_bUseEnvelope && m_pcConnectedEnvGenerator->IsActive())
+		return (last_level_byte & 0xee) == 0;
+
+	return (last_level_byte == 0) || (m_nMixMode == 0);
+}
+
 
 void CSAAAmp::Tick()
 {
@@ -557,6 +573,12 @@ bool CSAAEnv::IsActive () const
 	return m_bEnabled;
 }
 
+bool CSAAEnv::IsRunning () const
+{
+	// still changing level on the internal clock, which comes from a tone generator
+	return m_bEnabled && !m_bClockExternally && (!m_bEnvelopeEnded || m_bNewData);
+}
+
 
 //////////////////////////////////////////////////////////////////////
 // CSAAFreq: frequency generator
@@ -738,6 +760,12 @@ unsigned short CSAAFreq::Tick()
 }
 
 
+bool CSAAFreq::HasNewData() const
+{
+	// octave or offset data buffered until the end of the current half-cycle
+	return m_bNewData;
+}
+
 void CSAAFreq::SetAdd()
 {
 	// nOctave between 0 and 7; nOffset between 0 and 255
@@ -1174,3 +1202,133 @@ void CSAASound::GenerateMany(BYTE * pBuffer, int nSamples)
 		*pBuffer++ = stereoval.sep.Right >> 8;
 	}
 }
+
+bool CSAASound::IsSilent() const
+{
+	// the generators must keep running for an envelope clocked from them, or
+	// for buffered frequency data, as either changes what's heard later
+	for (int i=0; i<2; i++)
+	{
+		if (Env[i]->IsRunning())
+			return false;
+	}
+
+	for (int i=0; i<6; i++)
+	{
+		if (Osc[i]->HasNewData())
+			return false;
+	}
+
+	// otherwise all amps give zero output until the next register write, so
+	// there's nothing to generate (only tone and noise phase are left behind)
+	if (!m_bOutputEnabled)
+		return true;
+
+	for (int i=0; i<6; i++)
+	{
+		if (!Amp[i]->IsSilent())
+			return false;
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Snapshot support: only the changing state is stored, as the generator
+// connections and tables are fixed at construction
+
+void CSAAEnv::Serialize(CState & state)
+{
+	// store the envelope shape as a table index rather than a pointer
+	BYTE nEnvData = (BYTE)(m_pEnvData - cs_EnvData);
+	state.Value(nEnvData);
+	if (state.IsLoading() && nEnvData < 8)
+		m_pEnvData = &cs_EnvData[nEnvData];
+
+	state.Value(m_nLeftLevel);
+	state.Value(m_nRightLevel);
+	state.Value(m_bEnabled);
+	state.Value(m_bInvertRightChannel);
+	state.Value(m_nPhase);
+	state.Value(m_nPhasePosition);
+	state.Value(m_bEnvelopeEnded);
+	state.Value(m_nPhaseAdd);
+	state.Value(m_nCurrentPhaseAdd);
+	state.Value(m_bLooping);
+	state.Value(m_nNumberOfPhases);
+	state.Value(m_nResolution);
+	state.Value(m_nInitialLevel);
+	state.Value(m_bNewData);
+	state.Value(m_nNextData);
+	state.Value(m_bOkForNewData);
+	state.Value(m_bClockExternally);
+}
+
+void CSAANoise::Serialize(CState & state)
+{
+	state.Value(m_nCounter);
+	state.Value(m_nAdd);
+	state.Value(m_bSync);
+	state.Value(m_nSampleRateTimes4K);
+	state.Value(m_nSourceMode);
+	state.Value(m_nRand);
+}
+
+void CSAAFreq::Serialize(CState & state)
+{
+	state.Value(m_nCounter);
+	state.Value(m_nAdd);
+	state.Value(m_nLevel);
+	state.Value(m_nCurrentOffset);
+	state.Value(m_nCurrentOctave);
+	state.Value(m_nNextOffset);
+	state.Value(m_nNextOctave);
+	state.Value(m_bIgnoreOffsetData);
+	state.Value(m_bNewData);
+	state.Value(m_bSync);
+	state.Value(m_nSampleRateMode);
+	state.Value(m_nSampleRateTimes4K);
+}
+
+void CSAAAmp::Serialize(CState & state)
+{
+	state.Value(leftleveltimes16);
+	state.Value(leftleveltimes32);
+	state.Value(leftlevela0x0e);
+	state.Value(leftlevela0x0etimes2);
+	state.Value(rightleveltimes16);
+	state.Value(rightleveltimes32);
+	state.Value(rightlevela0x0e);
+	state.Value(rightlevela0x0etimes2);
+	state.Value(monoleveltimes16);
+	state.Value(monoleveltimes32);
+	state.Value(m_nOutputIntermediate);
+	state.Value(m_nMixMode);
+	state.Value(m_bMute);
+	state.Value(last_level_byte);
+	state.Value(level_unchanged);
+	state.Value(last_leftlevel);
+	state.Value(last_rightlevel);
+	state.Value(leftlevel_unchanged);
+	state.Value(rightlevel_unchanged);
+	state.Value(cached_last_leftoutput);
+	state.Value(cached_last_rightoutput);
+}
+
+void CSAASound::Serialize(CState & state)
+{
+	state.Value(m_nCurrentSaaReg);
+	state.Value(m_bOutputEnabled);
+	state.Value(m_bSync);
+
+	for (int i=0; i<6; i++)
+	{
+		Osc[i]->Serialize(state);
+		Amp[i]->Serialize(state);
+	}
+
+	Noise[0]->Serialize(state);
+	Noise[1]->Serialize(state);
+	Env[0]->Serialize(state);
+	Env[1]->Serialize(state);
+}
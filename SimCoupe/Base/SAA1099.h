@@ -8,6 +8,8 @@
 #ifndef SAA1099_H
 #define SAA1099_H
 
+class CState;
+
 class CSAAEnv
 {
 	typedef struct
@@ -52,6 +54,8 @@ public:
 	unsigned short LeftLevel() const;
 	unsigned short RightLevel() const;
 	bool IsActive() const;
+	bool IsRunning() const;
+	void Serialize(CState & state);
 
 };
 
@@ -86,6 +90,7 @@ public:
 	unsigned short Level() const;
 	unsigned short LevelTimesTwo() const;
 	void Sync(bool bSync);
+	void Serialize(CState & state);
 
 };
 
@@ -125,6 +130,8 @@ public:
 	void Sync(bool bSync);
 	unsigned short Tick();
 	unsigned short Level() const;
+	bool HasNewData() const;
+	void Serialize(CState & state);
 
 };
 
@@ -169,9 +176,11 @@ public:
 	unsigned short RightOutput() const;
 	unsigned short MonoOutput() const;
 	void Mute(bool bMute);
+	bool IsSilent() const;
 	void Tick();
 	unsigned short TickAndOutputMono();
 	stereolevel TickAndOutputStereo();
+	void Serialize(CState & state);
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -199,6 +208,8 @@ public:
 	BYTE ReadAddress();
 
 	void GenerateMany(BYTE * pBuffer, int nSamples);
+	bool IsSilent() const;
+	void Serialize(CState & state);
 };
 
 #endif // SAA1099_H
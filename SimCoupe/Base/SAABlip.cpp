@@ -0,0 +1,635 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// SAABlip.cpp: Event-driven band-limited SAA 1099 synthesis
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Notes:
+//
+//  Register handling follows CSAASound, including its buffering of frequency
+//  changes to the next half-cycle, and the envelope generators are shared with
+//  it.  Times are kept in SAA clocks, where a tone half-cycle is exactly
+//  (511-offset) << (8-octave) clocks and noise shifts every 256 << source.
+//
+//  Edges are only generated one at a time for generators that can currently
+//  be heard.  The rest are stepped over in bulk at the end of each run, which
+//  still clocks any noise or envelope generator driven from them.
+
+#include "SimCoupe.h"
+#include "SAABlip.h"
+
+#include "State.h"
+
+// Volume giving the same step sizes as CSAASound, where the range spans the full 16 bits
+const double SAA_VOLUME = SAA_MAX_LEVEL * 10.0 / 65536.0;
+
+//////////////////////////////////////////////////////////////////////////////
+
+CSAABlip::CSAABlip (long lCpuClock_, long lSampleRate_)
+    : m_lCpuClock(lCpuClock_)
+{
+    // Same clock and rate as the DAC, so both give the same samples per frame
+    m_bufLeft.clock_rate(lCpuClock_);
+    m_bufRight.clock_rate(lCpuClock_);
+    m_bufLeft.set_sample_rate(lSampleRate_);
+    m_bufRight.set_sample_rate(lSampleRate_);
+
+    m_synthLeft.output(&m_bufLeft);
+    m_synthRight.output(&m_bufRight);
+    m_synthLeft.volume(SAA_VOLUME);
+    m_synthRight.volume(SAA_VOLUME);
+
+    Clear();
+}
+
+// Reset the chip, as CSAASound::Clear() does
+void CSAABlip::Clear ()
+{
+    m_dwNow = 0;
+    m_nReg = 0;
+    m_bToneMix = m_bNoiseMix = 0;
+    m_fEnabled = m_fSync = false;
+    memset(m_abAmp, 0, sizeof(m_abAmp));
+
+    for (int i = 0 ; i < 6 ; i++)
+    {
+        SAA_TONE &t = m_asTone[i];
+        memset(&t, 0, sizeof(t));
+        t.fHigh = true;
+
+        SetTone(i);
+        t.dwNext = t.dwHalf;
+
+        m_anLeft[i] = m_anRight[i] = 0;
+    }
+
+    // Same seeds as CSAASound
+    m_asNoise[0].dwRand = 0x14af5209;
+    m_asNoise[1].dwRand = 0x76a9b11e;
+
+    for (int n = 0 ; n < 2 ; n++)
+    {
+        m_asNoise[n].nSource = 0;
+        m_asNoise[n].dwNext = 256;
+    }
+
+    m_nLeft = m_nRight = 0;
+    m_nQuietFrames = 0;
+    m_bufLeft.clear();
+    m_bufRight.clear();
+
+    // Sync and mute, clear the other registers, then release sync
+    WriteAddress(28);
+    WriteData(2);
+
+    for (int i = 31 ; i >= 0 ; i--)
+    {
+        if (i != 28)
+        {
+            WriteAddress(i);
+            WriteData(0);
+        }
+    }
+
+    WriteAddress(28);
+    WriteData(0);
+    WriteAddress(0);
+}
+
+// Restart the generators from the start of a frame, after frames generated elsewhere
+void CSAABlip::Resync ()
+{
+    m_dwNow = 0;
+
+    for (int i = 0 ; i < 6 ; i++)
+        m_asTone[i].dwNext = m_asTone[i].dwHalf;
+
+    for (int n = 0 ; n < 2 ; n++)
+        m_asNoise[n].dwNext = 256 << (m_asNoise[n].nSource & 3);
+
+    // Start the new output from silence, which only needs the area a frame start reaches
+    m_nLeft = m_nRight = 0;
+    m_bufLeft.clear(false);
+    m_bufRight.clear(false);
+
+    for (int i = 0 ; i < 6 ; i++)
+        UpdateAmp(i);
+
+    Output(0);
+}
+
+
+void CSAABlip::WriteAddress (BYTE bReg_)
+{
+    m_nReg = bReg_ & 31;
+
+    // Selecting an envelope register clocks it, if externally clocked
+    if (m_nReg == 24 || m_nReg == 25)
+    {
+        int n = m_nReg - 24;
+        m_aEnv[n].ExternalClock();
+
+        UpdateAmp(n*3 + 2);
+        Output(m_dwNow);
+    }
+}
+
+void CSAABlip::WriteData (BYTE bVal_)
+{
+    switch (m_nReg)
+    {
+        case 0: case 1: case 2: case 3: case 4: case 5:
+            m_abAmp[m_nReg] = bVal_;
+            UpdateAmp(m_nReg);
+            break;
+
+        case 8: case 9: case 10: case 11: case 12: case 13:
+        {
+            int i = m_nReg - 8;
+            SAA_TONE &t = m_asTone[i];
+
+            if (!m_fSync)
+            {
+                // Buffered until the next half-cycle, with offset after octave ignored for one of them
+                t.bNextOffset = bVal_;
+                t.fNewData = true;
+
+                if (t.bNextOctave == t.bOctave)
+                    t.fIgnoreOffset = true;
+            }
+            else
+            {
+                t.fNewData = false;
+                t.bOffset = bVal_;
+                t.bOctave = t.bNextOctave;
+                SetTone(i);
+            }
+            break;
+        }
+
+        case 16: case 17: case 18:
+        {
+            for (int i = (m_nReg - 16) * 2, nShift = 0 ; nShift <= 4 ; i++, nShift += 4)
+            {
+                SAA_TONE &t = m_asTone[i];
+                BYTE bOctave = (bVal_ >> nShift) & 0x07;
+
+                if (!m_fSync)
+                {
+                    t.bNextOctave = bOctave;
+                    t.fNewData = true;
+                    t.fIgnoreOffset = false;
+                }
+                else
+                {
+                    t.fNewData = false;
+                    t.bOctave = bOctave;
+                    t.bOffset = t.bNextOffset;
+                    SetTone(i);
+                }
+            }
+            break;
+        }
+
+        case 20:
+            m_bToneMix = bVal_ & 0x3f;
+            for (int i = 0 ; i < 6 ; i++) UpdateAmp(i);
+            break;
+
+        case 21:
+            m_bNoiseMix = bVal_ & 0x3f;
+            for (int i = 0 ; i < 6 ; i++) UpdateAmp(i);
+            break;
+
+        case 22:
+            for (int n = 0 ; n < 2 ; n++)
+            {
+                int nSource = (bVal_ >> (n*4)) & 0x03;
+
+                // Leaving tone clocking restarts the fixed rate count
+                if (m_asNoise[n].nSource == 3 && nSource != 3)
+                    m_asNoise[n].dwNext = m_dwNow + (256 << nSource);
+
+                m_asNoise[n].nSource = nSource;
+            }
+            break;
+
+        case 24: case 25:
+        {
+            int n = m_nReg - 24;
+            m_aEnv[n].SetEnvControl(bVal_);
+            UpdateAmp(n*3 + 2);
+            break;
+        }
+
+        case 28:
+            SetSync((bVal_ & 0x02) != 0);
+            m_fEnabled = (bVal_ & 0x01) != 0;
+            for (int i = 0 ; i < 6 ; i++) UpdateAmp(i);
+            break;
+
+        default:
+            // Unused register
+            return;
+    }
+
+    UpdateEvents();
+    Output(m_dwNow);
+}
+
+
+// Generate up to the given CPU cycle in the current frame
+void CSAABlip::Run (DWORD dwCycles_)
+{
+    DWORD dwEnd = ToChip(dwCycles_);
+    if (dwEnd <= m_dwNow)
+        return;
+
+    // Nothing moves while synced
+    if (!m_fSync)
+    {
+        for (;;)
+        {
+            DWORD dwNext = dwEnd;
+            int nNext = -1;
+
+            // Find the next edge that could be heard
+            for (int i = 0 ; i < 6 ; i++)
+            {
+                if ((m_bToneEvents & (1 << i)) && m_asTone[i].dwNext < dwNext)
+                    dwNext = m_asTone[i].dwNext, nNext = i;
+            }
+
+            for (int n = 0 ; n < 2 ; n++)
+            {
+                if ((m_bNoiseEvents & (1 << n)) && m_asNoise[n].nSource != 3 && m_asNoise[n].dwNext < dwNext)
+                    dwNext = m_asNoise[n].dwNext, nNext = 6+n;
+            }
+
+            if (nNext < 0)
+                break;
+
+            if (nNext < 6)
+            {
+                int n = nNext / 3;
+                Toggle(nNext, 1);
+
+                UpdateAmp(nNext);
+
+                // Driven noise or envelope affects the other amps too
+                if (nNext == n*3 && m_asNoise[n].nSource == 3)
+                    UpdateAmp(n*3), UpdateAmp(n*3 + 1), UpdateAmp(n*3 + 2);
+                else if (nNext == n*3 + 1)
+                    UpdateAmp(n*3 + 2);
+            }
+            else
+            {
+                int n = nNext - 6;
+                Shift(n, 1);
+                m_asNoise[n].dwNext += 256 << m_asNoise[n].nSource;
+
+                UpdateAmp(n*3), UpdateAmp(n*3 + 1), UpdateAmp(n*3 + 2);
+            }
+
+            Output(dwNext);
+        }
+
+        // Step over the edges of generators that can't currently be heard
+        for (int i = 0 ; i < 6 ; i++)
+        {
+            SAA_TONE &t = m_asTone[i];
+
+            while (!(m_bToneEvents & (1 << i)) && t.dwNext < dwEnd)
+            {
+                // Buffered data changes the period after the next edge
+                DWORD dwCount = t.fNewData ? 1 : (dwEnd - 1 - t.dwNext) / t.dwHalf + 1;
+                Toggle(i, dwCount);
+            }
+        }
+
+        for (int n = 0 ; n < 2 ; n++)
+        {
+            SAA_NOISE &s = m_asNoise[n];
+
+            if (!(m_bNoiseEvents & (1 << n)) && s.nSource != 3 && s.dwNext < dwEnd)
+            {
+                DWORD dwPeriod = 256 << s.nSource;
+                DWORD dwCount = (dwEnd - 1 - s.dwNext) / dwPeriod + 1;
+
+                Shift(n, dwCount);
+                s.dwNext += dwCount * dwPeriod;
+            }
+        }
+    }
+
+    m_dwNow = dwEnd;
+}
+
+// End the frame at the given CPU cycle, making its samples available
+void CSAABlip::FrameEnd (DWORD dwCycles_)
+{
+    Run(dwCycles_);
+
+    DWORD dwEnd = ToChip(dwCycles_);
+
+    // Make times relative to the next frame, leaving idle generators at zero
+    for (int i = 0 ; i < 6 ; i++)
+        m_asTone[i].dwNext = (m_asTone[i].dwNext > dwEnd) ? m_asTone[i].dwNext - dwEnd : 0;
+
+    for (int n = 0 ; n < 2 ; n++)
+        m_asNoise[n].dwNext = (m_asNoise[n].dwNext > dwEnd) ? m_asNoise[n].dwNext - dwEnd : 0;
+
+    m_dwNow = (m_dwNow > dwEnd) ? m_dwNow - dwEnd : 0;
+
+    m_bufLeft.end_frame(dwCycles_);
+    m_bufRight.end_frame(dwCycles_);
+
+    if (m_nQuietFrames < 2)
+        m_nQuietFrames++;
+}
+
+// Read interleaved 16-bit stereo samples, returning the number read
+int CSAABlip::ReadSamples (BYTE *pb_, int nSamples_)
+{
+    blip_sample_t *ps = reinterpret_cast<blip_sample_t*>(pb_);
+    long lAvail = m_bufLeft.samples_avail();
+    int nSamples = static_cast<int>(min(lAvail, static_cast<long>(nSamples_)));
+
+    m_bufLeft.read_samples(ps, nSamples, 1);
+    m_bufRight.read_samples(ps+1, nSamples, 1);
+
+    // Anything left over would only build up
+    if (lAvail > nSamples)
+    {
+        m_bufLeft.remove_samples(lAvail - nSamples);
+        m_bufRight.remove_samples(lAvail - nSamples);
+    }
+
+    return nSamples;
+}
+
+// Drop the ended frame without reading it if it's known to be all zero samples, returning true if so
+bool CSAABlip::DiscardSilence ()
+{
+    // Changes in the previous frame can still have impulse tails in this one
+    if (m_nQuietFrames < 2)
+        return false;
+
+    // The filtered level must also have settled to zero, which is the first sample it'd give
+    Blip_Reader left, right;
+    left.begin(m_bufLeft);
+    right.begin(m_bufRight);
+
+    if (left.read() || right.read())
+        return false;
+
+    // The buffers hold nothing, so only the position moves
+    m_bufLeft.remove_silence(m_bufLeft.samples_avail());
+    m_bufRight.remove_silence(m_bufRight.samples_avail());
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+Blip_Buffer::blip_resampled_time_t CSAABlip::Resampled (DWORD dwClock_) const
+{
+    // Scale chip clocks to CPU cycles within the factor multiply, to keep the fraction
+    unsigned long long ullTime = static_cast<unsigned long long>(dwClock_) * m_bufLeft.factor_ * m_lCpuClock / SAA_CLOCK;
+    return m_bufLeft.resampled_time(0) + static_cast<Blip_Buffer::blip_resampled_time_t>(ullTime);
+}
+
+// Set the half-cycle length from the current octave and offset
+void CSAABlip::SetTone (int nTone_)
+{
+    SAA_TONE &t = m_asTone[nTone_];
+    t.dwHalf = static_cast<DWORD>(511 - t.bOffset) << (8 - t.bOctave);
+}
+
+// Run a tone through a number of half-cycles, clocking anything driven by it
+void CSAABlip::Toggle (int nTone_, DWORD dwCount_)
+{
+    SAA_TONE &t = m_asTone[nTone_];
+    int n = nTone_ / 3;
+
+    if (dwCount_ & 1)
+        t.fHigh = !t.fHigh;
+
+    if (nTone_ == n*3 && m_asNoise[n].nSource == 3)
+        Shift(n, dwCount_);
+    else if (nTone_ == n*3 + 1)
+    {
+        for (DWORD dw = dwCount_ ; dw > 0 ; dw--)
+            m_aEnv[n].InternalClock();
+    }
+
+    t.dwNext += (dwCount_ - 1) * t.dwHalf;
+
+    // Pick up buffered frequency data, which sets the length of the following half-cycle
+    if (t.fNewData)
+    {
+        t.bOctave = t.bNextOctave;
+
+        if (!t.fIgnoreOffset)
+        {
+            t.bOffset = t.bNextOffset;
+            t.fNewData = false;
+        }
+
+        t.fIgnoreOffset = false;
+        SetTone(nTone_);
+    }
+
+    t.dwNext += t.dwHalf;
+}
+
+// Advance a noise generator a number of steps
+void CSAABlip::Shift (int nNoise_, DWORD dwCount_)
+{
+    DWORD dwRand = m_asNoise[nNoise_].dwRand;
+
+    while (dwCount_-- > 0)
+    {
+        DWORD dwTaps = dwRand & 0x40000004;
+        dwRand = (dwRand << 1) | (dwTaps && dwTaps != 0x40000004);
+    }
+
+    m_asNoise[nNoise_].dwRand = dwRand;
+}
+
+void CSAABlip::SetSync (bool fSync_)
+{
+    if (fSync_)
+    {
+        // Hold tones high, taking the latest frequency data
+        for (int i = 0 ; i < 6 ; i++)
+        {
+            SAA_TONE &t = m_asTone[i];
+            t.fHigh = true;
+            t.bOctave = t.bNextOctave;
+            t.bOffset = t.bNextOffset;
+            SetTone(i);
+        }
+    }
+    else if (m_fSync)
+    {
+        // Counting restarts from the release
+        for (int i = 0 ; i < 6 ; i++)
+            m_asTone[i].dwNext = m_dwNow + m_asTone[i].dwHalf;
+
+        for (int n = 0 ; n < 2 ; n++)
+            m_asNoise[n].dwNext = m_dwNow + (256 << (m_asNoise[n].nSource & 3));
+    }
+
+    m_fSync = fSync_;
+}
+
+// Work out which generators need their individual edges, after a register change
+void CSAABlip::UpdateEvents ()
+{
+    m_bToneEvents = m_bNoiseEvents = 0;
+
+    if (!m_fEnabled)
+        return;
+
+    for (int i = 0 ; i < 6 ; i++)
+    {
+        int n = i / 3;
+
+        // A silent amp doesn't need anything
+        if (!m_abAmp[i])
+            continue;
+
+        if (m_bToneMix & (1 << i))
+            m_bToneEvents |= 1 << i;
+
+        if (m_bNoiseMix & (1 << i))
+        {
+            m_bNoiseEvents |= 1 << n;
+
+            if (m_asNoise[n].nSource == 3)
+                m_bToneEvents |= 1 << (n*3);
+        }
+
+        // Envelope amps follow the envelope clock
+        if (i == n*3 + 2 && m_aEnv[n].IsActive())
+            m_bToneEvents |= 1 << (n*3 + 1);
+    }
+}
+
+// Calculate the output of one amp, as CSAAAmp does
+void CSAABlip::UpdateAmp (int nAmp_)
+{
+    int n = nAmp_ / 3;
+    int nMix = ((m_bToneMix >> nAmp_) & 1) | (((m_bNoiseMix >> nAmp_) & 1) << 1);
+    int nTone = m_asTone[nAmp_].fHigh ? 2 : 0;
+    int nNoise = m_asNoise[n].dwRand & 1;
+    int nLevel = 0, nLeft = 0, nRight = 0;
+    BYTE bAmp = m_abAmp[nAmp_];
+
+    switch (nMix)
+    {
+        case 1: nLevel = nTone; break;
+        case 2: nLevel = nNoise << 1; break;
+        case 3: nLevel = (nTone == 2 && nNoise) ? 1 : nTone; break;
+    }
+
+    if (!m_fEnabled)
+        ;
+    else if (nAmp_ == n*3 + 2 && m_aEnv[n].IsActive())
+    {
+        // Envelope output is reduced by tone/noise, rather than added to
+        if (nLevel < 2)
+        {
+            nLeft = (m_aEnv[n].LeftLevel() * (bAmp & 0x0e)) << (1 - nLevel);
+            nRight = (m_aEnv[n].RightLevel() * ((bAmp >> 4) & 0x0e)) << (1 - nLevel);
+        }
+    }
+    else
+    {
+        nLeft = (bAmp & 0x0f) * 16 * nLevel;
+        nRight = (bAmp >> 4) * 16 * nLevel;
+    }
+
+    m_anLeft[nAmp_] = nLeft;
+    m_anRight[nAmp_] = nRight;
+}
+
+// Pass any change in the summed output to the synths
+void CSAABlip::Output (DWORD dwClock_)
+{
+    int nLeft = 0, nRight = 0;
+
+    for (int i = 0 ; i < 6 ; i++)
+    {
+        nLeft += m_anLeft[i];
+        nRight += m_anRight[i];
+    }
+
+    if (nLeft != m_nLeft || nRight != m_nRight)
+        m_nQuietFrames = 0;
+
+    if (nLeft != m_nLeft)
+    {
+        m_synthLeft.offset_resampled(Resampled(dwClock_), nLeft - m_nLeft, &m_bufLeft);
+        m_nLeft = nLeft;
+    }
+
+    if (nRight != m_nRight)
+    {
+        m_synthRight.offset_resampled(Resampled(dwClock_), nRight - m_nRight, &m_bufRight);
+        m_nRight = nRight;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Save or restore between frames, after FrameEnd() and all samples have been read
+void CSAABlip::Serialize (CState &state_)
+{
+    blip_buffer_state_t asBuf[2];
+
+    if (!state_.IsLoading())
+    {
+        m_bufLeft.save_state(&asBuf[0]);
+        m_bufRight.save_state(&asBuf[1]);
+    }
+
+    state_.Value(m_dwNow);
+    state_.Value(m_nReg);
+    state_.Value(m_abAmp);
+    state_.Value(m_bToneMix);
+    state_.Value(m_bNoiseMix);
+    state_.Value(m_fEnabled);
+    state_.Value(m_fSync);
+    state_.Value(m_asTone);
+    state_.Value(m_asNoise);
+    m_aEnv[0].Serialize(state_);
+    m_aEnv[1].Serialize(state_);
+    state_.Value(m_anLeft);
+    state_.Value(m_anRight);
+    state_.Value(m_nLeft);
+    state_.Value(m_nRight);
+    state_.Value(m_nQuietFrames);
+    state_.Value(asBuf);
+
+    if (state_.IsLoading() && state_.IsOk())
+    {
+        m_bufLeft.load_state(asBuf[0]);
+        m_bufRight.load_state(asBuf[1]);
+        UpdateEvents();
+    }
+}
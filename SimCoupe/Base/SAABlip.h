@@ -0,0 +1,109 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// SAABlip.h: Event-driven band-limited SAA 1099 synthesis
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef SAABLIP_H
+#define SAABLIP_H
+
+#include "SAA1099.h"
+#include "BlipBuffer.h"
+
+#define SAA_CLOCK           8000000     // SAA 1099 master clock on the SAM
+
+// Largest change in the summed output of the 6 amps (6 * 15*32)
+const int SAA_MAX_LEVEL = 2880;
+
+
+// Alternative to CSAASound::GenerateMany that works out when each generator
+// next changes, rather than ticking them all at every output sample.  Only
+// changes in the summed output are passed to Blip_Synth, so the cost follows
+// the number of edges, and high tones don't alias.
+class CSAABlip
+{
+    public:
+        CSAABlip (long lCpuClock_, long lSampleRate_);
+
+    public:
+        void Clear ();
+        void Resync ();
+
+        void WriteAddress (BYTE bReg_);
+        void WriteData (BYTE bVal_);
+
+        void Run (DWORD dwCycles_);
+        void FrameEnd (DWORD dwCycles_);
+        int ReadSamples (BYTE *pb_, int nSamples_);
+        bool DiscardSilence ();
+
+        void Serialize (CState &state_);
+
+    protected:
+        typedef struct
+        {
+            DWORD dwNext;           // chip clock of the next half-cycle
+            DWORD dwHalf;           // half-cycle length in chip clocks
+            BYTE bOctave, bOffset;
+            BYTE bNextOctave, bNextOffset;
+            bool fNewData, fIgnoreOffset;
+            bool fHigh;
+        }
+        SAA_TONE;
+
+        typedef struct
+        {
+            DWORD dwNext;           // chip clock of the next shift, for sources 0-2
+            DWORD dwRand;           // shift register, with the level in bit 0
+            int nSource;            // 0-2 for fixed rates, 3 for tone 0 or 3
+        }
+        SAA_NOISE;
+
+        DWORD ToChip (DWORD dwCycles_) const { return static_cast<DWORD>(static_cast<unsigned long long>(dwCycles_) * SAA_CLOCK / m_lCpuClock); }
+        Blip_Buffer::blip_resampled_time_t Resampled (DWORD dwClock_) const;
+
+        void SetTone (int nTone_);
+        void Toggle (int nTone_, DWORD dwCount_);
+        void Shift (int nNoise_, DWORD dwCount_);
+        void SetSync (bool fSync_);
+        void UpdateEvents ();
+        void UpdateAmp (int nAmp_);
+        void Output (DWORD dwClock_);
+
+    protected:
+        long m_lCpuClock;
+        DWORD m_dwNow;              // chip clock generated up to
+
+        int m_nReg;
+        BYTE m_abAmp[6];
+        BYTE m_bToneMix, m_bNoiseMix;
+        bool m_fEnabled, m_fSync;
+
+        SAA_TONE m_asTone[6];
+        SAA_NOISE m_asNoise[2];
+        CSAAEnv m_aEnv[2];
+
+        BYTE m_bToneEvents, m_bNoiseEvents;   // generators whose edges can change the output
+        int m_anLeft[6], m_anRight[6];        // current output of each amp
+        int m_nLeft, m_nRight;                // summed output last passed to the synths
+        int m_nQuietFrames;                   // frames ended since the output last changed
+
+        Blip_Buffer m_bufLeft, m_bufRight;
+        Blip_Synth<blip_good_quality,SAA_MAX_LEVEL> m_synthLeft, m_synthRight;
+};
+
+#endif  // SAABLIP_H
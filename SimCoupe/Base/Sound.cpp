@@ -26,21 +26,37 @@
 #include "CPU.h"
 #include "Frame.h"
 #include "Options.h"
+#include "Profile.h"
+#include "Resample.h"
 #include "SID.h"
+#include "State.h"
 #include "WAV.h"
 
+#define MIX_UNITY       256     // source gain for full level, as 8-bit fixed point
+#define MIX_CHUNK       512     // sample values summed per pass over the sources
+
+// Mix bus input: a frame of interleaved 16-bit samples, and the gain to apply
+typedef struct
+{
+    const short *ps;
+    int nGain;
+}
+MIX_SOURCE;
+
 static BYTE *pbSampleBuffer;
+static CResampler *pResampler;
+static bool fMuted;     // Output discarded, for frames undone by a snapshot restore, such as run-ahead
 
-static void MixAudio (BYTE *pDst_, const BYTE *pSrc_, int nLen_);
-static int AdjustSpeed (BYTE *pb_, int nSize_, int nSpeed_);
+static int AddSource (MIX_SOURCE *psSources_, int nSources_, CSoundDevice *pDevice_, int nVolume_);
+static void MixAudio (short *pDst_, const MIX_SOURCE *psSources_, int nSources_, int nLen_);
 
 //////////////////////////////////////////////////////////////////////////////
 
 bool Sound::Init (bool fFirstInit_/*=false*/)
 {
-    int nMaxFrameSamples = 2; // Needed for 50% running speed
     int nSamplesPerFrame = (SAMPLE_FREQ / EMULATED_FRAMES_PER_SECOND)+1;
-    pbSampleBuffer = new BYTE[nSamplesPerFrame*SAMPLE_BLOCK*nMaxFrameSamples];
+    pbSampleBuffer = new BYTE[nSamplesPerFrame*SAMPLE_BLOCK];
+    pResampler = new CResampler(nSamplesPerFrame);
 
     bool fRet = Audio::Init(fFirstInit_);
     Audio::Silence();
@@ -54,6 +70,7 @@ void Sound::Exit (bool fReInit_/*=false*/)
     AVI::Stop();
 
     delete[] pbSampleBuffer, pbSampleBuffer = NULL;
+    delete pResampler, pResampler = NULL;
     Audio::Exit(fReInit_);
 }
 
@@ -62,6 +79,19 @@ void Sound::Silence ()
     Audio::Silence();
 }
 
+// Discard the sound output for frames that won't be heard
+void Sound::SetMuted (bool fMuted_)
+{
+    fMuted = fMuted_;
+}
+
+// Nudge the output rate by a few parts per million, to keep pace with the host's audio clock
+void Sound::SetRateAdjust (int nPPM_)
+{
+    if (pResampler)
+        pResampler->SetAdjust(nPPM_);
+}
+
 void Sound::FrameUpdate ()
 {
     static bool fSidUsed = false;
@@ -73,32 +103,61 @@ void Sound::FrameUpdate ()
     pSAA->FrameEnd();   // catch-up to the DAC position
     if (fSidUsed) pSID->FrameEnd();
 
+    // Nothing more to do if the samples aren't wanted
+    if (fMuted)
+        return;
+
     // Use the DAC as the master clock for sample count
     int nSamples = pDAC->GetSampleCount();
     int nSize = nSamples*SAMPLE_BLOCK;
 
-    // Copy in the DAC samples, then mix SAA and possibly SID too
-    memcpy(pbSampleBuffer, pDAC->GetSampleBuffer(), nSize);
-    MixAudio(pbSampleBuffer, pSAA->GetSampleBuffer(), nSize);
-    if (fSidUsed && GetOption(sid)) MixAudio(pbSampleBuffer, pSID->GetSampleBuffer(), nSize);
+    // Mix the DAC with any SAA output, and possibly SID too
+    MIX_SOURCE asSources[3];
+    int nSources = AddSource(asSources, 0, pDAC, GetOption(dacvolume));
+    if (!pSAA->IsSilent()) nSources = AddSource(asSources, nSources, pSAA, GetOption(saavolume));
+    if (fSidUsed && GetOption(sid)) nSources = AddSource(asSources, nSources, pSID, GetOption(sidvolume));
+    MixAudio(reinterpret_cast<short*>(pbSampleBuffer), asSources, nSources, nSamples*SAMPLE_CHANNELS);
 
     // Add the frame to any recordings
     WAV::AddFrame(pbSampleBuffer, nSize);
     AVI::AddFrame(pbSampleBuffer, nSize);
 
-#if SAMPLE_FREQ == 44100 && SAMPLE_BITS == 16 && SAMPLE_CHANNELS == 2
-    // Scale the audio to fit the require running speed
-    nSize = AdjustSpeed(pbSampleBuffer, nSize, GetOption(speed));
-#endif
+    // Convert to the output rate, stretched or squeezed to fit the running speed
+    int nOutRate = max(8000, min(GetOption(outputfreq), 192000));
+    int nSpeed = max(50, min(GetOption(speed), 1000));
+    pResampler->Configure(SAMPLE_FREQ, nOutRate, nSpeed, GetOption(resampler) != 0);
+
+    int nOut;
+    short *psOut = pResampler->Process(reinterpret_cast<short*>(pbSampleBuffer), nSamples, nOut);
 
     // Queue the data for playback
-    Audio::AddData(pbSampleBuffer, nSize);
+    Audio::AddData(reinterpret_cast<BYTE*>(psOut), nOut*SAMPLE_BLOCK);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+CSAA::CSAA ()
+{
+    // Both engines follow the registers, so either can be switched to between frames
+    m_pSAASound = new CSAASound(SAMPLE_FREQ);
+    m_pSAABlip = new CSAABlip(REAL_TSTATES_PER_SECOND, SAMPLE_FREQ);
+    m_fBlip = GetOption(saablip);
+    m_fSilent = true;
+}
+
 void CSAA::Update (bool fFrameEnd_=false)
 {
+    if (m_fBlip)
+    {
+        // Edges are generated as far as the CPU has reached, with the rest at frame end
+        if (!fFrameEnd_ && !fMuted)
+        {
+            CProfileSection section(PROF_SOUND);
+            m_pSAABlip->Run(min(g_dwCycleCounter, static_cast<DWORD>(TSTATES_PER_FRAME)));
+        }
+        return;
+    }
+
     int nSamplesSoFar = fFrameEnd_ ? pDAC->GetSampleCount() : pDAC->GetSamplesSoFar();
 
     int nNeeded = nSamplesSoFar - m_nSamplesThisFrame;
@@ -107,18 +166,65 @@ void CSAA::Update (bool fFrameEnd_=false)
 
     BYTE *pb = m_pbFrameSample + m_nSamplesThisFrame*SAMPLE_BLOCK;
 
-    if (g_fReset)
-        memset(pb, 0x00, nNeeded*SAMPLE_BLOCK); // no clock means no SAA output
+    // Start each frame assuming silence, until something audible is generated
+    if (!m_nSamplesThisFrame)
+        m_fSilent = true;
+
+    if (fMuted)
+        ;   // output won't be used, so save generating it
+    else if (g_fReset || m_pSAASound->IsSilent())
+    {
+        // No clock or no audible channels means zero output, which only needs
+        // writing if earlier parts of the frame weren't silent
+        if (!m_fSilent)
+            memset(pb, 0x00, nNeeded*SAMPLE_BLOCK);
+    }
     else
+    {
+        // Fill in any silence skipped earlier in the frame
+        if (m_fSilent)
+        {
+            memset(m_pbFrameSample, 0x00, m_nSamplesThisFrame*SAMPLE_BLOCK);
+            m_fSilent = false;
+        }
+
+        CProfileSection section(PROF_SOUND);
         m_pSAASound->GenerateMany(pb, nNeeded);
+    }
 
     m_nSamplesThisFrame = nSamplesSoFar;
 }
 
 void CSAA::FrameEnd ()
 {
-    Update(true);
+    if (m_fBlip && fMuted)
+        ;   // undone by a snapshot restore, which also resets the buffers, so nothing to generate or read
+    else if (m_fBlip)
+    {
+        CProfileSection section(PROF_SOUND);
+        m_pSAABlip->FrameEnd(TSTATES_PER_FRAME);
+
+        // Skip reading a frame that's known to be silent
+        m_fSilent = m_pSAABlip->DiscardSilence();
+
+        if (!m_fSilent)
+        {
+            // The buffers match the DAC clock and rate, so should have the same sample count
+            int nSamples = pDAC->GetSampleCount();
+            int nRead = m_pSAABlip->ReadSamples(m_pbFrameSample, nSamples);
+            memset(m_pbFrameSample + nRead*SAMPLE_BLOCK, 0x00, (nSamples-nRead)*SAMPLE_BLOCK);
+        }
+    }
+    else
+    {
+        Update(true);
+
+        // Keep the idle engine ready to take over from the next frame
+        m_pSAABlip->Resync();
+    }
+
     m_nSamplesThisFrame = 0;
+    m_fBlip = GetOption(saablip);
 }
 
 void CSAA::Out (WORD wPort_, BYTE bVal_)
@@ -126,9 +232,25 @@ void CSAA::Out (WORD wPort_, BYTE bVal_)
     Update();
 
     if ((wPort_ & SOUND_MASK) == SOUND_ADDR)
+    {
         m_pSAASound->WriteAddress(bVal_);
+        m_pSAABlip->WriteAddress(bVal_);
+    }
     else
+    {
         m_pSAASound->WriteData(bVal_);
+        m_pSAABlip->WriteData(bVal_);
+    }
+}
+
+void CSAA::Serialize (CState &state_)
+{
+    m_pSAASound->Serialize(state_);
+    m_pSAABlip->Serialize(state_);
+
+    // Both engines are saved, so use whichever is selected now
+    if (state_.IsLoading())
+        m_fBlip = GetOption(saablip);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -209,6 +331,33 @@ int CDAC::GetSamplesSoFar ()
     return static_cast<int>(buf_left.count_samples(uCycles));
 }
 
+// Save or restore the band-limited buffers between frames, after FrameEnd() has read all samples
+void CDAC::Serialize (CState &state_)
+{
+    blip_buffer_state_t asBuf[2];
+    int anAmps[] = { synth_left.last_amp(), synth_right.last_amp(), synth_left2.last_amp(), synth_right2.last_amp() };
+
+    if (!state_.IsLoading())
+    {
+        buf_left.save_state(&asBuf[0]);
+        buf_right.save_state(&asBuf[1]);
+    }
+
+    state_.Value(asBuf);
+    state_.Value(anAmps);
+
+    if (state_.IsLoading() && state_.IsOk())
+    {
+        buf_left.load_state(asBuf[0]);
+        buf_right.load_state(asBuf[1]);
+
+        synth_left.last_amp(anAmps[0]);
+        synth_right.last_amp(anAmps[1]);
+        synth_left2.last_amp(anAmps[2]);
+        synth_right2.last_amp(anAmps[3]);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void CBeeperDevice::Out(WORD wPort_, BYTE bVal_)
@@ -231,63 +380,56 @@ CSoundDevice::CSoundDevice ()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-// Basic audio mixing
-static void MixAudio (BYTE *pDst_, const BYTE *pSrc_, int nLen_)
+// Add a device's frame to the mix sources, unless its volume percentage mutes it
+static int AddSource (MIX_SOURCE *psSources_, int nSources_, CSoundDevice *pDevice_, int nVolume_)
 {
-    for (nLen_ /= 2 ; nLen_-- > 0 ; pSrc_ += 2, pDst_ += 2)
+    if (nVolume_ > 0)
     {
-        // Add two 16-bit samples
-        short s1 = (pSrc_[1] << 8) | pSrc_[0];
-        short s2 = (pDst_[1] << 8) | pDst_[0];
-        int samp = s1 + s2;
-
-        // Clip to signed range
-        samp = min(samp, 32767);
-        samp = max(-32768, samp);
-
-        // Write new sample
-        pDst_[0] = samp & 0xff;
-        pDst_[1] = samp >> 8;
+        psSources_[nSources_].ps = reinterpret_cast<const short*>(pDevice_->GetSampleBuffer());
+        psSources_[nSources_].nGain = nVolume_ * MIX_UNITY / 100;
+        nSources_++;
     }
-}
 
+    return nSources_;
+}
 
-// Scale audio data to fit the current emulator speed setting
-static int AdjustSpeed (BYTE *pb_, int nSize_, int nSpeed_)
+// Mix bus: sum the scaled sources into the output in a single pass, saturating to 16 bits
+static void MixAudio (short *pDst_, const MIX_SOURCE *psSources_, int nSources_, int nLen_)
 {
-    // Limit speed range
-    nSpeed_ = max(nSpeed_,50);
-    nSpeed_ = min(nSpeed_,1000);
-
-    // Slow?
-    if (nSpeed_ < 100)
+    // A lone source at full level is a straight copy
+    if (nSources_ == 1 && psSources_[0].nGain == MIX_UNITY)
     {
-        DWORD *pdwS = reinterpret_cast<DWORD*>(pb_ + nSize_) - 1;
-        DWORD *pdwD = reinterpret_cast<DWORD*>(pb_ + nSize_*2) - 1;
+        memcpy(pDst_, psSources_[0].ps, nLen_*sizeof(*pDst_));
+        return;
+    }
 
-        // Double samples in reverse order
-        for (int i = 0 ; i < nSize_ ; i += SAMPLE_BLOCK, pdwS--)
-            *pdwD-- = *pdwS, *pdwD-- = *pdwS;
+    int an[MIX_CHUNK];
 
-        nSize_ *= 2;
-    }
-    else if (nSpeed_ == 100)
-    {
-        // Nothing to do
-    }
-    // Fast?
-    else if (nSpeed_ > 100)
+    for (int nDone = 0 ; nDone < nLen_ ; nDone += MIX_CHUNK)
     {
-        int nScale = nSpeed_/100;
-        nSize_ = (nSize_/nScale) & ~(SAMPLE_BLOCK-1);
+        int nChunk = min(nLen_-nDone, MIX_CHUNK);
+        int i;
 
-        DWORD *pdwS = reinterpret_cast<DWORD*>(pb_);
-        DWORD *pdwD = pdwS;
+        // Accumulate with headroom in loops simple enough for the compiler to vectorise
+        for (i = 0 ; i < nChunk ; i++)
+            an[i] = 0;
 
-        // Skip the required number of samples
-        for (int i = 0 ; i < nSize_ ; i += SAMPLE_BLOCK, pdwS += nScale)
-            *pdwD++ = *pdwS;
-    }
+        for (int n = 0 ; n < nSources_ ; n++)
+        {
+            const short *ps = psSources_[n].ps + nDone;
+            int nGain = psSources_[n].nGain;
 
-    return nSize_;
+            for (i = 0 ; i < nChunk ; i++)
+                an[i] += (ps[i] * nGain) >> 8;
+        }
+
+        // Clip to signed range
+        short *pd = pDst_ + nDone;
+
+        for (i = 0 ; i < nChunk ; i++)
+        {
+            int nSample = an[i];
+            pd[i] = static_cast<short>(nSample < -32768 ? -32768 : nSample > 32767 ? 32767 : nSample);
+        }
+    }
 }
@@ -23,6 +23,7 @@
 
 #include "IO.h"
 #include "SAA1099.h"
+#include "SAABlip.h"
 #include "BlipBuffer.h"
 
 #define SAMPLE_FREQ			44100
@@ -39,6 +40,9 @@ class Sound
 
         static void Silence ();
         static void FrameUpdate ();
+
+        static void SetMuted (bool fMuted_);
+        static void SetRateAdjust (int nPPM_);
 };
 
 class CSoundDevice : public CIoDevice
@@ -59,17 +63,23 @@ class CSoundDevice : public CIoDevice
 class CSAA : public CSoundDevice
 {
     public:
-        CSAA () { m_pSAASound = new CSAASound(SAMPLE_FREQ); }
-        ~CSAA () { delete m_pSAASound; }
+        CSAA ();
+        ~CSAA () { delete m_pSAASound; delete m_pSAABlip; }
 
     public:
         void Update (bool fFrameEnd_);
         void FrameEnd ();
 
         void Out (WORD wPort_, BYTE bVal_);
+        void Serialize (CState &state_);
+
+        bool IsSilent () const { return m_fSilent; }
 
     protected:
         CSAASound *m_pSAASound;
+        CSAABlip *m_pSAABlip;
+        bool m_fBlip;           // band-limited engine generating this frame
+        bool m_fSilent;         // frame output is all zero so far, and the buffer may not hold it
 };
 
 
@@ -92,6 +102,7 @@ class CDAC : public CSoundDevice
         void Output2 (BYTE bVal_);
 
         int GetSamplesSoFar ();
+        void Serialize (CState &state_);
 
     protected:
         Blip_Buffer buf_left, buf_right;
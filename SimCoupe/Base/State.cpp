@@ -0,0 +1,122 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// State.cpp: Save state snapshots
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Snapshots are raw machine state in native byte order, taken between frames.
+// They're intended for in-session use (frontend save slots, rewind, run-ahead),
+// so only the running state is stored, not disk images or settings.
+
+#include "SimCoupe.h"
+#include "State.h"
+
+#include "CPU.h"
+#include "Frame.h"
+#include "IO.h"
+#include "Memory.h"
+#include "Options.h"
+
+const DWORD STATE_MAGIC = 0x53435353;   // "SCSS" (SimCoupe save state)
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t State::GetSize ()
+{
+    CState state;
+    Serialize(state);
+    return state.GetSize();
+}
+
+bool State::Save (void *pv_, size_t uSize_)
+{
+    CState state(reinterpret_cast<BYTE*>(pv_), uSize_, false);
+    Serialize(state);
+    return state.IsOk();
+}
+
+bool State::Load (const void *pv_, size_t uSize_)
+{
+    // Reject short data before anything is changed
+    if (uSize_ < GetSize())
+        return false;
+
+    // The buffer is only read from when loading
+    CState state(const_cast<BYTE*>(reinterpret_cast<const BYTE*>(pv_)), uSize_, true);
+    Serialize(state);
+    return state.IsOk();
+}
+
+
+void State::Serialize (CState &state_)
+{
+    DWORD dwMagic = STATE_MAGIC;
+    WORD wVersion = STATE_VERSION;
+
+    // The memory layout depends on the current configuration
+    BYTE abConfig[] = {
+        static_cast<BYTE>(GetOption(mainmem) == 256),
+        static_cast<BYTE>(min(GetOption(externalmem), MAX_EXTERNAL_MB)),
+        static_cast<BYTE>(GetOption(romwrite) != 0)
+    };
+    BYTE abSaved[sizeof(abConfig)];
+    memcpy(abSaved, abConfig, sizeof(abConfig));
+
+    state_.Value(dwMagic);
+    state_.Value(wVersion);
+    state_.Data(abSaved, sizeof(abSaved));
+
+    // Refuse snapshots from a different format version or memory configuration
+    if (state_.IsLoading() && (dwMagic != STATE_MAGIC || wVersion != STATE_VERSION || memcmp(abSaved, abConfig, sizeof(abConfig))))
+        state_.Fail();
+
+    if (!state_.IsOk())
+        return;
+
+    SerializeMachine(state_);
+    Memory::Serialize(state_);
+}
+
+void State::SerializeMachine (CState &state_)
+{
+    CPU::Serialize(state_);
+    IO::Serialize(state_);
+    Frame::Serialize(state_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef RETRO
+extern "C" size_t State_GetSize();
+extern "C" int State_Save(void *pv_, size_t uSize_);
+extern "C" int State_Load(const void *pv_, size_t uSize_);
+
+size_t State_GetSize ()
+{
+    return State::GetSize();
+}
+
+int State_Save (void *pv_, size_t uSize_)
+{
+    return State::Save(pv_, uSize_);
+}
+
+int State_Load (const void *pv_, size_t uSize_)
+{
+    return State::Load(pv_, uSize_);
+}
+#endif
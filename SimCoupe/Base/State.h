@@ -0,0 +1,88 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// State.h: Save state snapshots
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef STATE_H
+#define STATE_H
+
+// Snapshot format version, to be bumped whenever the layout changes
+const WORD STATE_VERSION = 3;
+
+
+// Snapshot stream, used in one direction for both saving and loading so each
+// component describes its state once.  With no buffer it just measures the size.
+class CState
+{
+    public:
+        CState () : m_pb(NULL), m_uSize(0), m_uPos(0), m_fLoad(false), m_fOk(true) { }
+        CState (BYTE *pb_, size_t uSize_, bool fLoad_)
+            : m_pb(pb_), m_uSize(uSize_), m_uPos(0), m_fLoad(fLoad_), m_fOk(true) { }
+
+    public:
+        bool IsLoading () const { return m_fLoad; }
+        bool IsOk () const { return m_fOk; }
+        size_t GetSize () const { return m_uPos; }
+
+        void Data (void *pv_, size_t uLen_)
+        {
+            if (m_pb)
+            {
+                // Refuse to overrun the supplied buffer
+                if (!m_fOk || m_uPos + uLen_ > m_uSize)
+                {
+                    m_fOk = false;
+                    return;
+                }
+
+                if (m_fLoad)
+                    memcpy(pv_, m_pb + m_uPos, uLen_);
+                else
+                    memcpy(m_pb + m_uPos, pv_, uLen_);
+            }
+
+            m_uPos += uLen_;
+        }
+
+        template <typename T> void Value (T &t_) { Data(&t_, sizeof(t_)); }
+
+        // Flag the data as unusable, such as a version or configuration mismatch
+        void Fail () { m_fOk = false; }
+
+    protected:
+        BYTE *m_pb;
+        size_t m_uSize, m_uPos;
+        bool m_fLoad, m_fOk;
+};
+
+
+class State
+{
+    public:
+        static size_t GetSize ();
+        static bool Save (void *pv_, size_t uSize_);
+        static bool Load (const void *pv_, size_t uSize_);
+
+        // Machine state excluding memory, for callers managing memory themselves
+        static void SerializeMachine (CState &state_);
+
+    protected:
+        static void Serialize (CState &state_);
+};
+
+#endif  // STATE_H
@@ -269,7 +269,8 @@ bool Tape::LoadTrap ()
         if (!nWanted)
             break;
 
-        // Write new byte
+        // Write new byte, which may be to the display
+        check_video_write(wDest);
         write_byte(wDest, H);
         wDest++;
         nWanted--;
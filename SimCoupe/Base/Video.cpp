@@ -82,6 +82,25 @@ void Video::Update (CScreen* pScreen_)
         pVideo->Update(pScreen_, afDirty);
 }
 
+// Convert a span of a completed line to the display, for VCAP_DIRECT implementations
+void Video::DrawLine (CScreen* pScreen_, int nLine_, int nFrom_, int nTo_)
+{
+    if (pVideo)
+        pVideo->DrawLine(pScreen_, nLine_, nFrom_, nTo_);
+}
+
+// Does the display still hold the last frame drawn by line, so only changed spans need drawing?
+bool Video::IsRetained ()
+{
+    return pVideo && pVideo->IsRetained();
+}
+
+// Is the last frame drawn by line still what's displayed, so an unchanged frame needn't be drawn at all?
+bool Video::IsCurrent ()
+{
+    return pVideo && pVideo->IsCurrent();
+}
+
 void Video::UpdateSize ()
 {
     if (pVideo)
@@ -23,7 +23,7 @@
 
 #include "Screen.h"
 
-enum { VCAP_STRETCH=1, VCAP_FILTER=2, VCAP_SCANHIRES=4 };
+enum { VCAP_STRETCH=1, VCAP_FILTER=2, VCAP_SCANHIRES=4, VCAP_DIRECT=8 };
 
 class Video
 {
@@ -38,6 +38,9 @@ class Video
         static bool CheckCaps (int nCaps_);
 
         static void Update (CScreen* pScreen_);
+        static void DrawLine (CScreen* pScreen_, int nLine_, int nFrom_, int nTo_);
+        static bool IsRetained ();
+        static bool IsCurrent ();
         static void UpdateSize ();
         static void UpdatePalette ();
 
@@ -56,6 +59,9 @@ class VideoBase
         virtual bool Init (bool fFirstInit_) = 0;
 
         virtual void Update (CScreen* pScreen_, bool *pafDirty_) = 0;
+        virtual void DrawLine (CScreen* /*pScreen_*/, int /*nLine_*/, int /*nFrom_*/, int /*nTo_*/) { }  // only used with VCAP_DIRECT
+        virtual bool IsRetained () const { return false; }
+        virtual bool IsCurrent () const { return false; }
         virtual void UpdateSize () = 0;
         virtual void UpdatePalette () = 0;
 
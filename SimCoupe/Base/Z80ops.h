@@ -43,9 +43,16 @@
 
 // Basic instruction header, specifying opcode and nominal T-States of the first M-Cycle
 // The first three T-States of the first M-Cycle are already accounted for
-#define instr(m1states, opcode) case opcode: { \
+// The body is a do-while block so a 'break' ends the instruction early in either dispatch model
+#ifdef Z80_DISPATCH
+#define instr(m1states, opcode) op_##opcode: do { \
                                     g_dwCycleCounter += m1states - 3;
-#define endinstr                } break
+#define endinstr                } while (0); Z80_DISPATCH
+#else
+#define instr(m1states, opcode) case opcode: do { \
+                                    g_dwCycleCounter += m1states - 3;
+#define endinstr                } while (0); break
+#endif
 
 // Indirect HL instructions affected by IX/IY prefixes
 #define HLinstr(opcode)         instr(4, opcode) \
@@ -629,7 +636,7 @@ instr(5,0357)   push(PC); PC = 050;                                 endinstr;
 instr(5,0367)   if (IO::Rst48Hook()) break; push(PC); PC = 060;     endinstr;   // rst 48
 instr(5,0377)   push(PC); PC = 070;                                 endinstr;   // rst 56
 
-#ifdef NODEFAULT
+#if defined(NODEFAULT) && !defined(Z80_DISPATCH)
     default: NODEFAULT;
 #endif
 
@@ -20,17 +20,25 @@
 
 #include "SimCoupe.h"
 
+#include <pthread.h>
+
 #include "Audio.h"
 #include "Sound.h"
 
 #include "CPU.h"
 #include "IO.h"
 #include "Options.h"
+#include "Resample.h"
 #include "Util.h"
 #include "UI.h"
 
 #define SAMPLE_BUFFER_SIZE	2048
 
+#define RING_FRAMES         8192    // ring size in stereo sample frames, a power of 2
+#define CACHE_LINE          64      // spacing to keep the ring indices on separate cache lines
+#define SILENCE_FRAMES      256     // silence given to the frontend when the ring runs dry
+#define WAIT_MS             20      // longest wait for the other side, about a frame
+
 #define Uint8 unsigned char
 #define Uint32 unsigned 
 
@@ -38,9 +46,41 @@ static Uint8 *m_pbStart, *m_pbEnd, *m_pbNow;
 static int m_nSampleBufferSize;
 static Uint32 uLastTime;
 
+// Single-producer single-consumer ring, filled by the emulation and emptied by the frontend's
+// audio thread.  Each index is only written by one side, and counts frames without wrapping.
+static struct
+{
+    BYTE abPad0[CACHE_LINE];
+    UINT uHead;                             // frames written, advanced by the producer
+    BYTE abPad1[CACHE_LINE-sizeof(UINT)];
+    UINT uTail;                             // frames read, advanced by the consumer
+    BYTE abPad2[CACHE_LINE-sizeof(UINT)];
+    DWORD adwFrames[RING_FRAMES];           // 16-bit left and right pairs
+}
+sRing;
+
+static int nThreaded;                       // 0=direct to the frontend, 1=ring, 2=ring with the producer waiting for space
+static bool fRunning;                       // frontend is calling for audio
+static bool fFlush;                         // consumer to discard what's queued
+static bool fProducerWaiting, fConsumerWaiting;
+static UINT uLimit = RING_FRAMES;           // most frames to queue, from the latency setting
+static UINT uDropped, uUnderruns;
+
+static pthread_mutex_t mtxRing = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cvRing = PTHREAD_COND_INITIALIZER;    // Signalled when a waiting side's index moves
+
 static bool InitSDLSound ();
 static void ExitSDLSound ();
-static void SoundCallback (void *pvParam_, Uint8 *pbStream_, int nLen_);
+static void WaitForIndex (const UINT *puIndex_, UINT uSeen_, bool *pfWaiting_);
+static void Signal (bool *pfWaiting_);
+
+extern "C" void retro_audio_batch (const short *pData_, size_t uFrames_);
+extern "C" void Audio_SetSAABlip (int fBlip_);
+extern "C" void Audio_SetVolumes (int nDAC_, int nSAA_, int nSID_);
+extern "C" void Audio_SetOutput (int nRate_, int fSinc_);
+extern "C" void Audio_SetThreaded (int nThreaded_);
+extern "C" void Audio_SetState (bool fEnabled_);
+extern "C" void Audio_Callback ();
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -85,88 +125,90 @@ void Audio::Exit (bool fReInit_/*=false*/)
 
 bool Audio::AddData (Uint8* pbData_, int nLength_)
 {
-#if 0
-    int nSpace = 0;
-
-    // Calculate the frame time (in ms) from the sample data length
-    int nFrameTime = ((nLength_*1000/SAMPLE_BLOCK) + (SAMPLE_FREQ/2)) / SAMPLE_FREQ;
-
-    // Loop until everything has been written
-    while (m_pbNow && nLength_ > 0)
+    // Without the audio thread, hand the whole frame of interleaved stereo samples to the frontend
+    if (!nThreaded)
     {
-        SDL_LockAudio();
+        retro_audio_batch(reinterpret_cast<const short*>(pbData_), nLength_/SAMPLE_BLOCK);
+        return true;
+    }
 
-        // Determine the available space
-        nSpace = static_cast<int>(m_pbEnd-m_pbNow);
-        int nAdd = min(nSpace, nLength_);
+    // Queue the latency setting in frames, plus one being played and one being added
+    int nFrameSamples = GetOption(outputfreq) / EMULATED_FRAMES_PER_SECOND + 1;
+    uLimit = min(static_cast<UINT>((GetOption(latency) + 2) * nFrameSamples), static_cast<UINT>(RING_FRAMES));
 
-        // Copy as much as we can
-        memcpy(m_pbNow, pbData_, nAdd);
+    const DWORD *pdw = reinterpret_cast<const DWORD*>(pbData_);
+    UINT uFrames = nLength_/SAMPLE_BLOCK;
+    UINT uHead = sRing.uHead, uTail = 0;
 
-        // Adjust for what was added
-        m_pbNow += nAdd;
-        pbData_ += nAdd;
-        nLength_ -= nAdd;
+    while (uFrames)
+    {
+        uTail = __atomic_load_n(&sRing.uTail, __ATOMIC_ACQUIRE);
+        UINT uQueued = uHead - uTail;
+        UINT uFree = (uQueued < uLimit) ? uLimit - uQueued : 0;
 
-        SDL_UnlockAudio();
+        if (!uFree)
+        {
+            // Wait for the audio thread to make space if we're synchronised to it, otherwise drop the rest
+            if (nThreaded == 2 && __atomic_load_n(&fRunning, __ATOMIC_ACQUIRE))
+            {
+                WaitForIndex(&sRing.uTail, uTail, &fProducerWaiting);
+                continue;
+            }
 
-        // All written?
-        if (!nLength_)
+            uDropped += uFrames;
             break;
+        }
 
-        // Wait for more space
-        SDL_Delay(1);
-    }
+        // Copy what fits, in two parts if it wraps
+        UINT uAdd = min(uFree, uFrames);
+        UINT uPos = uHead & (RING_FRAMES-1);
+        UINT uFirst = min(uAdd, RING_FRAMES-uPos);
 
-    // How long since the frame?
-    Uint32 uNow = SDL_GetTicks();
-    Sint32 nElapsed = static_cast<Sint32>(uNow - uLastTime);
+        memcpy(sRing.adwFrames + uPos, pdw, uFirst*sizeof(*pdw));
+        memcpy(sRing.adwFrames, pdw + uFirst, (uAdd-uFirst)*sizeof(*pdw));
 
-    // If we're too far behind, re-sync
-    if (nElapsed > nFrameTime*2)
-    {
-        uLastTime = uNow;
-    }
-    else
-    {
-        // If we're falling behind, reduce the delay by 1ms
-        if (nSpace > (SAMPLE_BUFFER_SIZE*SAMPLE_BLOCK))
-            nFrameTime--;
+        pdw += uAdd;
+        uFrames -= uAdd;
+        uHead += uAdd;
 
-        for (;;)
-        {
-            // How long since the last frame?
-            Sint32 nElapsed = static_cast<Sint32>(SDL_GetTicks() - uLastTime);
-
-            // Have we waited long enough?
-            if (nElapsed >= nFrameTime)
-            {
-                // Adjust for the next frame
-                uLastTime += nFrameTime;
-                break;
-            }
+        __atomic_store_n(&sRing.uHead, uHead, __ATOMIC_SEQ_CST);
+        Signal(&fConsumerWaiting);
+    }
 
-            // Sleep a short time before checking again
-            SDL_Delay(1);
+    // Without waiting, the emulation runs from the frontend's video clock, so steer the output rate
+    // to keep the ring about half full, rather than letting drift empty or overflow it
+    if (nThreaded == 1)
+    {
+        static int nAdjust;
+        int nTarget = static_cast<int>(uLimit/2);
+        int nError = static_cast<int>(uHead - uTail) - nTarget;
 
-        }
+        nAdjust += (nError * RESAMPLE_MAX_ADJUST / nTarget - nAdjust) / 8;
+        Sound::SetRateAdjust(nAdjust);
     }
-#endif
+
     return true;
 }
 
 void Audio::Silence ()
 {
-return;
-#if 0
-    if (!IsAvailable())
-        return;
+    // Only the consumer moves the tail, so ask it to discard what's queued
+    if (nThreaded)
+        __atomic_store_n(&fFlush, true, __ATOMIC_RELEASE);
+}
 
-    SDL_LockAudio();
-    memset(m_pbStart, 0x00, m_pbEnd-m_pbStart);
-    m_pbNow = m_pbEnd;
-    SDL_UnlockAudio();
-#endif
+// Report the queued audio as a time and as a percentage of the limit, if the audio thread is in use
+bool Audio::GetStats (int &nLatencyMs_, int &nFillPercent_)
+{
+    if (!nThreaded)
+        return false;
+
+    UINT uQueued = sRing.uHead - __atomic_load_n(&sRing.uTail, __ATOMIC_ACQUIRE);
+    nLatencyMs_ = static_cast<int>(uQueued * 1000 / GetOption(outputfreq));
+    nFillPercent_ = static_cast<int>(uQueued * 100 / uLimit);
+
+    TRACE("Audio ring: %dms, %d%% full, %u dropped, %u underruns\n", nLatencyMs_, nFillPercent_, uDropped, uUnderruns);
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -201,19 +243,119 @@ void ExitSDLSound ()
 #endif
 }
 
-// Callback used by SDL to request more sound data to play
-void SoundCallback (void *pvParam_, Uint8 *pbStream_, int nLen_)
+// Block until the other side moves its index on from the value last seen, or a frame's time has passed
+static void WaitForIndex (const UINT *puIndex_, UINT uSeen_, bool *pfWaiting_)
 {
-#if 0
-    // Determine how much data we have available, how much to copy, and what is left over
-    int nData = static_cast<int>(m_pbNow - m_pbStart);
-    int nCopy = min(nData, nLen_), nLeft = nData-nCopy;
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += WAIT_MS * 1000000L;
 
-    // Update the sound stream with what we have
-    memcpy(pbStream_, m_pbStart, nCopy);
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
 
-    // Move any remaining data to the start of our buffer
-    m_pbNow = m_pbStart + nLeft;
-    memmove(m_pbStart, m_pbStart+nCopy, nLeft);
-#endif
+    pthread_mutex_lock(&mtxRing);
+
+    // Flag the wait before re-checking, so a move made just before can't be missed
+    __atomic_store_n(pfWaiting_, true, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(puIndex_, __ATOMIC_SEQ_CST) == uSeen_)
+    {
+        if (pthread_cond_timedwait(&cvRing, &mtxRing, &ts))
+            break;
+    }
+
+    __atomic_store_n(pfWaiting_, false, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&mtxRing);
+}
+
+// Wake the other side if it's waiting for an index we've just moved
+static void Signal (bool *pfWaiting_)
+{
+    if (__atomic_load_n(pfWaiting_, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&mtxRing);
+        pthread_cond_broadcast(&cvRing);
+        pthread_mutex_unlock(&mtxRing);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Select the SAA engine from the core options, taking effect from the next frame
+void Audio_SetSAABlip (int fBlip_)
+{
+    SetOption(saablip, fBlip_ != 0);
+}
+
+void Audio_SetVolumes (int nDAC_, int nSAA_, int nSID_)
+{
+    SetOption(dacvolume, nDAC_);
+    SetOption(saavolume, nSAA_);
+    SetOption(sidvolume, nSID_);
+}
+
+void Audio_SetOutput (int nRate_, int fSinc_)
+{
+    SetOption(outputfreq, nRate_);
+    SetOption(resampler, fSinc_ != 0);
+}
+
+// Queue audio for the frontend's audio thread, once its callback is registered, rather than handing it over directly
+void Audio_SetThreaded (int nThreaded_)
+{
+    nThreaded = nThreaded_;
+    Sound::SetRateAdjust(0);
+}
+
+// Called by the frontend when it starts or stops calling for audio
+void Audio_SetState (bool fEnabled_)
+{
+    __atomic_store_n(&fRunning, fEnabled_, __ATOMIC_RELEASE);
+
+    // Don't leave the emulation waiting for a consumer that's gone
+    if (!fEnabled_)
+        Signal(&fProducerWaiting);
+}
+
+// Called on the frontend's audio thread when it wants more audio
+void Audio_Callback ()
+{
+    UINT uTail = sRing.uTail;
+    UINT uHead = __atomic_load_n(&sRing.uHead, __ATOMIC_ACQUIRE);
+
+    // Discard what was queued before a silence request
+    if (__atomic_exchange_n(&fFlush, false, __ATOMIC_ACQ_REL))
+        uTail = uHead;
+
+    // Give the emulation up to a frame's time to add more
+    if (uHead == uTail)
+    {
+        WaitForIndex(&sRing.uHead, uHead, &fConsumerWaiting);
+        uHead = __atomic_load_n(&sRing.uHead, __ATOMIC_ACQUIRE);
+    }
+
+    if (uHead == uTail)
+    {
+        // Top up the frontend with a little silence rather than returning empty-handed
+        static const DWORD adwSilence[SILENCE_FRAMES] = { 0 };
+        retro_audio_batch(reinterpret_cast<const short*>(adwSilence), SILENCE_FRAMES);
+        uUnderruns++;
+    }
+    else
+    {
+        // Pass on everything queued, in two parts if it wraps
+        UINT uFrames = uHead - uTail;
+        UINT uPos = uTail & (RING_FRAMES-1);
+        UINT uFirst = min(uFrames, RING_FRAMES-uPos);
+
+        retro_audio_batch(reinterpret_cast<const short*>(sRing.adwFrames + uPos), uFirst);
+        if (uFirst < uFrames)
+            retro_audio_batch(reinterpret_cast<const short*>(sRing.adwFrames), uFrames - uFirst);
+    }
+
+    __atomic_store_n(&sRing.uTail, uHead, __ATOMIC_SEQ_CST);
+    Signal(&fProducerWaiting);
 }
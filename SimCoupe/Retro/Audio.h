@@ -30,6 +30,8 @@ class Audio
         static bool IsAvailable () { return 0;/*SDL_GetAudioStatus() == SDL_AUDIO_PLAYING;*/ }
         static bool AddData (unsigned char*/*Uint8**/ pbData_, int nLength_);
         static void Silence ();
+
+        static bool GetStats (int &nLatencyMs_, int &nFillPercent_);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,514 @@
+// Part of SimCoupe - A SAM Coupe emulator
+//
+// Bench.cpp: Headless benchmark of the emulation core
+//
+//  Copyright (c) 2026 libretro-simcoupe contributors
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+// Notes:
+//
+//  Links the same objects as the libretro core, with null frontend callbacks,
+//  and runs frames back-to-back as fast as possible.  Usage:
+//
+//    simcp-bench [-frames n] [-warmup n] [-novideo] [-threaded] [-mode n] [-ramloop] [-saaloop] [-state file] [-saacompare] [-renderers] [disk] [SimCoupe options]
+//
+//  A disk image is booted as if given on the SimCoupe command line, and a
+//  snapshot from retro_serialize can be loaded over it with -state.
+//
+//  -mode switches to the given screen mode after the warmup, and fills the
+//  display memory with a random pattern, to compare the line renderers.
+//
+//  -renderers times each screen mode's line renderer on its own, in both
+//  resolutions, drawing the main screen lines of the given number of frames
+//  from the -mode test pattern.  Filling the same output bytes is timed too,
+//  as the least any renderer could take.
+//
+//  -ramloop replaces whatever is running after the warmup with a fixed loop in
+//  main RAM at 0x8000, which copies and sums blocks with interrupts disabled.
+//  Nearly every access is then contended, unlike the ROM idle loop.
+//
+//  -threaded converts frames on the video worker thread, as the core option does.
+//
+//  The output stage is timed under Flip when enabled with SimCoupe options,
+//  such as: -outscale 2 -ratio5_4 1 -crtmask 1
+//
+//  -saacompare runs the same frames twice from a snapshot taken after the
+//  warmup, once with each SAA engine, so both see the same register writes.
+//  The generation time and output level of each are reported, along with how
+//  closely the level follows from frame to frame.  The sample waveforms are
+//  not compared directly, as the band-limited output differs at every edge.
+//
+//  -saaloop runs a fixed loop in main RAM instead, which plays all 6 channels
+//  with noise and envelopes, changing amplitudes and frequencies many times a
+//  frame, so -saacompare has sound to compare without needing a disk image.
+//  It reads the keyboard to end the fast boot, which would skip the sound, and
+//  sets up the chip again every 64 passes, as writes are ignored until the
+//  ASIC has started after power-on.
+
+#include <math.h>
+
+#include "SimCoupe.h"
+
+#include "CPU.h"
+#include "Frame.h"
+#include "IO.h"
+#include "Memory.h"
+#include "Options.h"
+#include "Profile.h"
+#include "Sound.h"
+#include "State.h"
+
+#include "libretro.h"
+
+extern "C" int Smain (int argc_, char* argv_[]);
+extern "C" void CPU_Run1 ();
+extern "C" void texture_init ();
+extern "C" long GetTicks ();
+extern "C" int Video_SetThreaded (int fThreaded_);
+extern "C" const void *Video_Output (const void *pvFrame_, int fAll_);
+
+extern unsigned short int bmp[640 * 480];
+extern CFrame *pFrameLow, *pFrameHigh;
+
+extern "C" void retro_set_video_refresh (retro_video_refresh_t cb);
+extern "C" void retro_set_audio_sample_batch (retro_audio_sample_batch_t cb);
+
+// Loop run from main RAM for -ramloop
+static const BYTE abRamLoop[] =
+{
+    0xf3,               //       di
+    0x31, 0x00, 0xc0,   //       ld   sp,0xc000
+    0x21, 0x00, 0x81,   // loop: ld   hl,0x8100
+    0x11, 0x00, 0x90,   //       ld   de,0x9000
+    0x01, 0x00, 0x10,   //       ld   bc,0x1000
+    0xed, 0xb0,         //       ldir
+    0x21, 0x00, 0x90,   //       ld   hl,0x9000
+    0x06, 0x00,         //       ld   b,0
+    0xaf,               //       xor  a
+    0x86,               // sum:  add  a,(hl)
+    0x23,               //       inc  hl
+    0x77,               //       ld   (hl),a
+    0x10, 0xfb,         //       djnz sum
+    0xc5,               //       push bc
+    0xc1,               //       pop  bc
+    0x18, 0xe6          //       jr   loop
+};
+
+// Loop run from main RAM for -saaloop, writing SAA registers throughout each frame
+static const BYTE abSaaLoop[] =
+{
+    0xf3,               //        di
+    0x31, 0x00, 0xc0,   //        ld   sp,0xc000
+    0x21, 0x57, 0x80,   // init:  ld   hl,regs
+    0x7e,               // next:  ld   a,(hl)
+    0xfe, 0xff,         //        cp   0xff
+    0x28, 0x08,         //        jr   z,play
+    0x23,               //        inc  hl
+    0x5e,               //        ld   e,(hl)
+    0x23,               //        inc  hl
+    0xcd, 0x4e, 0x80,   //        call write
+    0x18, 0xf3,         //        jr   next
+    0x14,               // play:  inc  d
+    0xdb, 0xfe,         //        in   a,(0xfe)
+    0x7a,               //        ld   a,d
+    0xe6, 0x03,         //        and  3
+    0x5a,               //        ld   e,d
+    0xcd, 0x4e, 0x80,   //        call write
+    0x3e, 0x08,         //        ld   a,8
+    0x5a,               //        ld   e,d
+    0xcd, 0x4e, 0x80,   // freq:  call write
+    0x6f,               //        ld   l,a
+    0x7b,               //        ld   a,e
+    0x82,               //        add  a,d
+    0xc6, 0x3b,         //        add  a,0x3b
+    0x5f,               //        ld   e,a
+    0x7d,               //        ld   a,l
+    0x3c,               //        inc  a
+    0xfe, 0x0e,         //        cp   0x0e
+    0x20, 0xf1,         //        jr   nz,freq
+    0x7a,               //        ld   a,d
+    0xe6, 0x0f,         //        and  0x0f
+    0x20, 0x0f,         //        jr   nz,wait
+    0x3e, 0x10,         //        ld   a,0x10
+    0x5a,               //        ld   e,d
+    0xcd, 0x4e, 0x80,   //        call write
+    0x3c,               //        inc  a
+    0xcd, 0x4e, 0x80,   //        call write
+    0x7a,               //        ld   a,d
+    0xe6, 0x3f,         //        and  0x3f
+    0x28, 0xc0,         //        jr   z,init
+    0x21, 0x80, 0x04,   // wait:  ld   hl,0x0480
+    0x2b,               // delay: dec  hl
+    0x7c,               //        ld   a,h
+    0xb5,               //        or   l
+    0x20, 0xfb,         //        jr   nz,delay
+    0x18, 0xc6,         //        jr   play
+    0x01, 0xff, 0x01,   // write: ld   bc,0x01ff
+    0xed, 0x79,         //        out  (c),a
+    0x05,               //        dec  b
+    0xed, 0x59,         //        out  (c),e
+    0xc9,               //        ret
+    0x1c, 0x02,         // regs:  db   0x1c,0x02   ; reset
+    0x1c, 0x01,         //        db   0x1c,0x01   ; enable
+    0x14, 0x3f,         //        db   0x14,0x3f   ; tones on
+    0x15, 0x24,         //        db   0x15,0x24   ; noise on 2+5
+    0x16, 0x21,         //        db   0x16,0x21   ; noise rates
+    0x00, 0xf8,         //        db   0x00,0xf8
+    0x01, 0x8f,         //        db   0x01,0x8f
+    0x02, 0x77,         //        db   0x02,0x77
+    0x03, 0xa5,         //        db   0x03,0xa5
+    0x04, 0x5a,         //        db   0x04,0x5a
+    0x05, 0xcc,         //        db   0x05,0xcc   ; amplitudes
+    0x10, 0x43,         //        db   0x10,0x43
+    0x11, 0x25,         //        db   0x11,0x25
+    0x12, 0x51,         //        db   0x12,0x51   ; octaves
+    0x18, 0x8a,         //        db   0x18,0x8a
+    0x19, 0x96,         //        db   0x19,0x96   ; envelopes
+    0xff                //        db   0xff
+};
+
+static short *psCapture;     // audio capture position, if wanted
+static size_t uCaptureLeft;
+
+static void NullVideo (const void*, unsigned, unsigned, size_t) { }
+
+static size_t NullAudio (const int16_t* ps_, size_t uFrames_)
+{
+    size_t uFrames = min(uFrames_, uCaptureLeft);
+
+    if (psCapture)
+    {
+        memcpy(psCapture, ps_, uFrames * SAMPLE_BLOCK);
+        psCapture += uFrames * SAMPLE_CHANNELS;
+        uCaptureLeft -= uFrames;
+    }
+
+    return uFrames_;
+}
+
+
+// Load a snapshot saved by the libretro core
+static bool LoadState (const char* pcszFile_)
+{
+    FILE* f = fopen(pcszFile_, "rb");
+    if (!f)
+        return false;
+
+    size_t uSize = State::GetSize();
+    BYTE* pb = new BYTE[uSize];
+    bool fLoaded = fread(pb, 1, uSize, f) == uSize && State::Load(pb, uSize);
+
+    delete[] pb;
+    fclose(f);
+    return fLoaded;
+}
+
+// Switch to a screen mode showing a random pattern, so each renderer is timed on the same data
+static void SetTestMode (int nMode_)
+{
+    BYTE bPage = VMPR_PAGE & ~1;
+    BYTE *pb = PageWritePtr(bPage);
+    DWORD dwSeed = 0x12345678;
+
+    for (int i = 0 ; i < MEM_PAGE_SIZE*2 ; i++)
+    {
+        // Same xorshift sequence every run
+        dwSeed ^= dwSeed << 13;
+        dwSeed ^= dwSeed >> 17;
+        dwSeed ^= dwSeed << 5;
+        pb[i] = static_cast<BYTE>(dwSeed);
+    }
+
+    IO::Out(VMPR_PORT, ((nMode_-1) << VMPR_MODE_SHIFT) | bPage);
+}
+
+// Start a fixed loop in main RAM, with interrupts disabled so it runs without interruption
+static void SetRamLoop (const BYTE *pb_, int nSize_)
+{
+    for (int i = 0 ; i < nSize_ ; i++)
+        *AddrWritePtr(static_cast<WORD>(0x8000 + i)) = pb_[i];
+
+    PC = 0x8000;
+    IFF1 = IFF2 = 0;
+    regs.halted = 0;
+}
+
+// Run frames as fast as possible, with or without drawing them
+static void RunFrames (int nFrames_, bool fVideo_)
+{
+    while (nFrames_-- > 0)
+    {
+        if (!fVideo_)
+            fDrawFrame = false;
+
+        CPU_Run1();
+
+        // Pass the frame through the output stage, as the libretro core does
+        if (fVideo_)
+            Video_Output(bmp, 0);
+    }
+}
+
+// Time each line renderer over the main screen lines, against filling the same output
+static void TimeRenderers (int nFrames_)
+{
+    static const char* const aszNames[] = { "fill", "mode 1", "mode 2", "mode 3", "mode 4" };
+
+    CScreen screen(Frame::GetWidth(), Frame::GetHeight());
+    int nBlocks = s_nViewRight - s_nViewLeft;
+
+    printf("%d frames of %d main screen lines, per frame:\n", nFrames_, SCREEN_LINES);
+
+    for (int nMode = 0 ; nMode <= 4 ; nMode++)
+    {
+        if (nMode)
+            SetTestMode(nMode);
+
+        for (int nHiRes = 0 ; nHiRes < 2 ; nHiRes++)
+        {
+            CFrame *pFrame = nHiRes ? pFrameHigh : pFrameLow;
+            pFrame->SetMode(vmpr);
+
+            long lStart = GetTicks();
+
+            for (int f = 0 ; f < nFrames_ ; f++)
+            {
+                for (int nLine = TOP_BORDER_LINES ; nLine < TOP_BORDER_LINES+SCREEN_LINES ; nLine++)
+                {
+                    // Mode 0 is the fill alone
+                    if (nMode)
+                        pFrame->UpdateLine(&screen, nLine, 0, WIDTH_BLOCKS);
+                    else
+                        memset(screen.GetLine(nLine - s_nViewTop), f, nBlocks << (nHiRes ? 4 : 3));
+                }
+            }
+
+            long lElapsed = GetTicks() - lStart;
+            double dFrameUs = static_cast<double>(lElapsed) / nFrames_;
+
+            printf("  %-6s %s  %7.1fus  %5.1fns/line  %4.2f%% of a 50Hz frame\n", aszNames[nMode], nHiRes ? "hi-res" : "lo-res",
+                   dFrameUs, dFrameUs * 1000.0 / SCREEN_LINES, dFrameUs * EMULATED_FRAMES_PER_SECOND / 10000.0);
+        }
+    }
+}
+
+// Per-frame output level of one channel, with the DC offset of each frame removed
+static void FrameLevels (const short *ps_, int nFrames_, int nChannel_, double *pdLevels_)
+{
+    const int nPerFrame = SAMPLE_FREQ / EMULATED_FRAMES_PER_SECOND;
+
+    for (int f = 0 ; f < nFrames_ ; f++, ps_ += nPerFrame * SAMPLE_CHANNELS)
+    {
+        double dSum = 0.0, dSumSq = 0.0;
+
+        for (int i = 0 ; i < nPerFrame ; i++)
+        {
+            double d = ps_[i * SAMPLE_CHANNELS + nChannel_];
+            dSum += d;
+            dSumSq += d * d;
+        }
+
+        double dMean = dSum / nPerFrame;
+        pdLevels_[f] = sqrt(max(dSumSq / nPerFrame - dMean * dMean, 0.0));
+    }
+}
+
+// Run the same frames through both SAA engines, and compare the results
+static void CompareSAA (int nFrames_, bool fVideo_)
+{
+    const int nPerFrame = SAMPLE_FREQ / EMULATED_FRAMES_PER_SECOND;
+    size_t uStateSize = State::GetSize();
+    BYTE* pbState = new BYTE[uStateSize];
+    State::Save(pbState, uStateSize);
+    int nTurbo = g_nTurbo;   // not in the snapshot, as the boot may still be running
+
+    // Allow for the odd extra sample each frame
+    size_t uCapture = static_cast<size_t>(nFrames_) * (nPerFrame+1);
+    short* apsOut[2];
+    unsigned long aulTime[2];
+
+    for (int nEngine = 0 ; nEngine < 2 ; nEngine++)
+    {
+        // The loaded snapshot picks up the engine option
+        SetOption(saablip, nEngine != 0);
+        State::Load(pbState, uStateSize);
+        g_nTurbo = nTurbo;
+
+        apsOut[nEngine] = new short[uCapture * SAMPLE_CHANNELS];
+        memset(apsOut[nEngine], 0, uCapture * SAMPLE_BLOCK);
+        psCapture = apsOut[nEngine];
+        uCaptureLeft = uCapture;
+
+        Profile::Reset();
+        Profile::Enable(true);
+        RunFrames(nFrames_, fVideo_);
+        Profile::Enable(false);
+
+        aulTime[nEngine] = Profile::GetTime(PROF_SOUND);
+        psCapture = NULL;
+    }
+
+    printf("%d frames, SAA generate: per-sample %.3fs, band-limited %.3fs\n", nFrames_, aulTime[0] / 1000000.0, aulTime[1] / 1000000.0);
+
+    double *pdOld = new double[nFrames_], *pdNew = new double[nFrames_];
+    bool fSilent = true;
+
+    for (int nChannel = 0 ; nChannel < SAMPLE_CHANNELS ; nChannel++)
+    {
+        FrameLevels(apsOut[0], nFrames_, nChannel, pdOld);
+        FrameLevels(apsOut[1], nFrames_, nChannel, pdNew);
+
+        double dOld = 0.0, dNew = 0.0, dOldSq = 0.0, dNewSq = 0.0, dCross = 0.0;
+        for (int f = 0 ; f < nFrames_ ; f++)
+        {
+            dOld += pdOld[f], dNew += pdNew[f];
+            dOldSq += pdOld[f] * pdOld[f], dNewSq += pdNew[f] * pdNew[f];
+            dCross += pdOld[f] * pdNew[f];
+        }
+
+        // Correlation of the frame levels, which is undefined for a steady level
+        double dCov = dCross - dOld * dNew / nFrames_;
+        double dVar = (dOldSq - dOld * dOld / nFrames_) * (dNewSq - dNew * dNew / nFrames_);
+
+        printf("  %s: level per-sample %.1f, band-limited %.1f", nChannel ? "right" : "left ", dOld / nFrames_, dNew / nFrames_);
+        if (dVar > 0.0)
+            printf(", correlation %.3f", dCov / sqrt(dVar));
+        printf("\n");
+
+        fSilent &= (dOld == 0.0 && dNew == 0.0);
+    }
+
+    // Matching silence says nothing about the engines
+    if (fSilent)
+        printf("  no sound in either engine, so nothing was compared (try -saaloop)\n");
+
+    delete[] pdOld;
+    delete[] pdNew;
+    delete[] apsOut[0];
+    delete[] apsOut[1];
+    delete[] pbState;
+}
+
+
+int main (int argc_, char* argv_[])
+{
+    int nFrames = 3000, nWarmup = 0, nMode = 0;
+    bool fVideo = true, fThreaded = false, fRamLoop = false, fSaaLoop = false, fCompareSAA = false, fRenderers = false;
+    const char* pcszState = NULL;
+
+    // Take our own options, passing the rest on as SimCoupe options
+    char* apszArgs[64] = { argv_[0] };
+    int nArgs = 1;
+
+    for (int i = 1 ; i < argc_ ; i++)
+    {
+        if (!strcasecmp(argv_[i], "-frames") && i+1 < argc_)
+            nFrames = atoi(argv_[++i]);
+        else if (!strcasecmp(argv_[i], "-warmup") && i+1 < argc_)
+            nWarmup = atoi(argv_[++i]);
+        else if (!strcasecmp(argv_[i], "-novideo"))
+            fVideo = false;
+        else if (!strcasecmp(argv_[i], "-threaded"))
+            fThreaded = true;
+        else if (!strcasecmp(argv_[i], "-mode") && i+1 < argc_)
+            nMode = atoi(argv_[++i]);
+        else if (!strcasecmp(argv_[i], "-ramloop"))
+            fRamLoop = true;
+        else if (!strcasecmp(argv_[i], "-saaloop"))
+            fSaaLoop = true;
+        else if (!strcasecmp(argv_[i], "-state") && i+1 < argc_)
+            pcszState = argv_[++i];
+        else if (!strcasecmp(argv_[i], "-saacompare"))
+            fCompareSAA = true;
+        else if (!strcasecmp(argv_[i], "-renderers"))
+            fRenderers = true;
+        else if (nArgs < static_cast<int>(sizeof(apszArgs)/sizeof(apszArgs[0])))
+            apszArgs[nArgs++] = argv_[i];
+    }
+
+    retro_set_video_refresh(NullVideo);
+    retro_set_audio_sample_batch(NullAudio);
+
+    texture_init();
+    Smain(nArgs, apszArgs);
+
+    if (pcszState && !LoadState(pcszState))
+    {
+        fprintf(stderr, "Failed to load snapshot: %s\n", pcszState);
+        return 1;
+    }
+
+    if (fThreaded && !Video_SetThreaded(1))
+    {
+        fprintf(stderr, "Failed to start video thread\n");
+        return 1;
+    }
+
+    // Let the machine settle before timing, such as to get past the boot
+    RunFrames(nWarmup, fVideo);
+
+    if (nMode >= 1 && nMode <= 4)
+        SetTestMode(nMode);
+
+    if (fRamLoop)
+        SetRamLoop(abRamLoop, sizeof(abRamLoop));
+    else if (fSaaLoop)
+        SetRamLoop(abSaaLoop, sizeof(abSaaLoop));
+
+    if (fCompareSAA)
+    {
+        CompareSAA(nFrames, fVideo);
+        return 0;
+    }
+
+    if (fRenderers)
+    {
+        TimeRenderers(nFrames);
+        return 0;
+    }
+
+    Profile::Reset();
+    Profile::Enable(true);
+
+    long lStart = GetTicks();
+    RunFrames(nFrames, fVideo);
+    long lElapsed = GetTicks() - lStart;
+
+    Profile::Enable(false);
+
+    if (lElapsed <= 0)
+        lElapsed = 1;
+
+    double dSecs = lElapsed / 1000000.0;
+    double dTstates = static_cast<double>(nFrames) * TSTATES_PER_FRAME;
+
+    printf("%d frames, video %s%s, mode %d, %.3fs\n", nFrames, fVideo ? "on" : "off", fThreaded ? " (threaded)" : "", ((vmpr & VMPR_MODE_MASK) >> VMPR_MODE_SHIFT)+1, dSecs);
+    printf("%.1f frames/s (%.0f%% of real speed)\n", nFrames / dSecs, dTstates * 100.0 / REAL_TSTATES_PER_SECOND / dSecs);
+    printf("%.0f T-states/s (%.2f emulated MHz)\n", dTstates / dSecs, dTstates / dSecs / 1000000.0);
+
+    unsigned long ulProfiled = 0;
+    for (int i = 0 ; i < PROF_SECTIONS ; i++)
+    {
+        unsigned long ulTime = Profile::GetTime(i);
+        printf("  %-16s %9.3fs %5.1f%%\n", Profile::GetName(i), ulTime / 1000000.0, ulTime * 100.0 / lElapsed);
+        ulProfiled += ulTime;
+    }
+
+    unsigned long ulOther = static_cast<unsigned long>(lElapsed) > ulProfiled ? lElapsed - ulProfiled : 0;
+    printf("  %-16s %9.3fs %5.1f%%\n", "Other", ulOther / 1000000.0, ulOther * 100.0 / lElapsed);
+
+    return 0;
+}
@@ -26,6 +26,7 @@
 
 #include "MIDI.h"
 #include "Options.h"
+#include "State.h"
 
 #ifndef MIDIRESET
 #define MIDIRESET       (('M' << 8) | 01)
@@ -132,6 +133,13 @@ void CMidiDevice::Out (WORD wPort_, BYTE bVal_)
     m_nOut = m_abOut[1] = m_abOut[2] = m_abOut[3] = 0;
 }
 
+// Save or restore any partly built MIDI OUT message, as already sent messages can't be undone
+void CMidiDevice::Serialize (CState &state_)
+{
+    state_.Value(m_abOut);
+    state_.Value(m_nOut);
+}
+
 bool CMidiDevice::SetDevice (const char *pcszDevice_)
 {
     if (m_nDevice != -1)
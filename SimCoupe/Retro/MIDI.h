@@ -33,8 +33,11 @@ class CMidiDevice : public CIoDevice
         BYTE In (WORD wPort_);
         void Out (WORD wPort_, BYTE bVal_);
 
+        void Serialize (CState &state_);
+
     public:
         bool SetDevice (const char *pcszDevice_);
+        bool IsOpen () const { return m_nDevice != -1; }
 
     protected:
         BYTE    m_abIn[256], m_abOut[256];  // Buffers for MIDI IN and MIDI OUT data
@@ -4,12 +4,71 @@
 #include "Frame.h"
 #include "GUI.h"
 #include "Options.h"
+#include "Profile.h"
 #include "UI.h"
 
+#include <pthread.h>
+
 #define FULLSCREEN_DEPTH    16
 
 static DWORD aulPalette[N_PALETTE_COLOURS];
 static DWORD aulScanline[N_PALETTE_COLOURS];
+static DWORD adwPairs[0x10000];                 // Pairs of hi-res pixels, indexed by the two palette bytes read as a WORD
+static DWORD adwDoubled[N_PALETTE_COLOURS];     // Lo-res pixels, doubled to fill a DWORD
+static DWORD dwScanScale;                       // Scanline brightness out of 256, for scaling each colour channel
+
+extern unsigned short int bmp[640 * 480];
+
+static DWORD *pdwTarget = reinterpret_cast<DWORD*>(bmp);   // Display buffer we convert into
+static long lTargetPitchDW = 1280 >> 2;                     // DWORDs per row of the display buffer
+static bool fTargetDrawn;                                   // Anything drawn since the last check?
+static bool fRetained;                                      // Does bmp still hold the last frame drawn by line?
+static bool fCurrent;                                       // Is the last frame drawn by line still what the frontend shows?
+
+// Threaded mode converts whole frames on a worker thread, while the next frame is emulated
+static bool fThreaded;                                      // Hand completed frames to the worker?
+static pthread_t hWorker;                                   // Worker thread, once started
+static pthread_mutex_t mtxWorker = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cvWorker = PTHREAD_COND_INITIALIZER;  // Signalled when a job is queued or completed
+static bool fWorkerStarted, fWorkerExit;
+static CScreen *pJobScreen;                                 // Frame being converted, or NULL if the worker is idle
+static int nJobWidth, nJobHeight;                           // Frame size of the last job, for clearing the buffers on changes
+static bool fJobInterlace;                                  // Add scanline rows below each line?
+static bool fJobQueued;                                     // Job queued since threaded mode started?
+static bool fJobShown;                                      // Frame fetched for display since the latest job was queued?
+static int nJobFrame;                                       // Buffer the latest job converts into
+static unsigned short awFrames[2][640 * 480];               // Worker buffers, used alternately
+static const void *pvLastFrame;                             // Most recent completed worker buffer
+
+// Output stage, scaling the converted frame for the frontend
+const int MAX_OUTPUT_SCALE = 3;                             // Largest integer scale
+const int MAX_OUTPUT_WIDTH = 640 * MAX_OUTPUT_SCALE * 5/4;  // Widest output, at the largest scale stretched to 5:4
+const int CRT_MASK_LEVEL = 70;                              // Brightness of the other channels in each mask column (percent)
+
+static bool afRowDirty[480];                                // bmp rows changed since the output stage last used them
+static WORD *pwOutput;                                      // Output image, once the stage has been active
+static bool fOverlay;                                       // Are overlays drawn over bmp, so all of it must be passed on?
+static int nSrcWidth = 640, nSrcHeight = 480;               // Area of the converted frame passed on, normally the view
+static int nOutScale = 1;                                   // Integer scale the output image was built for
+static bool fOutRatio5_4, fOutCrtMask;                      // Stretched to 5:4? CRT mask applied?
+static int nOutWidth = 640, nOutHeight = 480;               // Output image size
+static WORD awOutColumn[MAX_OUTPUT_WIDTH];                  // Source column for each output column, when stretching
+static WORD awMaskR[MAX_OUTPUT_WIDTH], awMaskG[MAX_OUTPUT_WIDTH], awMaskB[MAX_OUTPUT_WIDTH];  // Channel scales out of 256
+
+static void WaitWorker ();
+static void QueueFrame (CScreen* pScreen_);
+static bool CheckOutput ();
+
+extern "C" int Video_SetTarget (void *pv_, int nPitch_, int nWidth_, int nHeight_);
+extern "C" int Video_TargetDrawn ();
+extern "C" void Video_Invalidate ();
+extern "C" int Video_SetThreaded (int fThreaded_);
+extern "C" const void *Video_ThreadedFrame ();
+extern "C" void Video_SetOutput (int nScale_, int fRatio5_4_, int fCrtMask_);
+extern "C" int Video_GetOutput (int *pnWidth_, int *pnHeight_);
+extern "C" const void *Video_Output (const void *pvFrame_, int fAll_);
+extern "C" void Video_SetOverlay (int fOverlay_);
+extern "C" void Video_SetBorders (int nBorders_);
 
 
 RetroVideo::RetroVideo ()
@@ -22,13 +81,29 @@ RetroVideo::RetroVideo ()
 
 RetroVideo::~RetroVideo ()
 {
+    Video_SetThreaded(0);
+
+    // Stop the worker thread, if it was started
+    if (fWorkerStarted)
+    {
+        pthread_mutex_lock(&mtxWorker);
+        fWorkerExit = true;
+        pthread_cond_broadcast(&cvWorker);
+        pthread_mutex_unlock(&mtxWorker);
+
+        pthread_join(hWorker, NULL);
+        fWorkerStarted = fWorkerExit = false;
+    }
+
     if (pBack) free(pBack), pBack = NULL;    
+    if (pwOutput) free(pwOutput), pwOutput = NULL;
 }
 
 
 int RetroVideo::GetCaps () const
 {
-	return 0;
+	// Converting whole frames on the worker replaces converting lines as they're drawn
+	return fThreaded ? 0 : VCAP_DIRECT;
 }
 
 bool RetroVideo::Init (bool fFirstInit_)
@@ -51,6 +126,13 @@ bool RetroVideo::Init (bool fFirstInit_)
 
 void RetroVideo::Update (CScreen* pScreen_, bool *pafDirty_)
 {
+	// Hand the frame to the worker thread, if active
+	if (fThreaded)
+	{
+		QueueFrame(pScreen_);
+		return;
+	}
+
 	// Draw any changed lines to the back buffer
 	if (!DrawChanges(pScreen_, pafDirty_))
 		return;
@@ -61,6 +143,9 @@ void RetroVideo::Update (CScreen* pScreen_, bool *pafDirty_)
 // Create whatever's needed for actually displaying the SAM image
 void RetroVideo::UpdatePalette ()
 {
+    // The worker mustn't be using the tables while we rebuild them
+    WaitWorker();
+
     // Determine the scanline brightness level adjustment, in the range -100 to +100
     int nScanAdjust = GetOption(scanlines) ? (GetOption(scanlevel) - 100) : 0;
     if (nScanAdjust < -100) nScanAdjust = -100;
@@ -77,17 +162,504 @@ void RetroVideo::UpdatePalette ()
         aulPalette[i] = RGB565(r>>3, g>>3, b>>3);//SDL_MapRGB(pBack->format, r,g,b);
         AdjustBrightness(r,g,b, nScanAdjust);
         aulScanline[i] = RGB565(r>>3, g>>3, b>>3);//SDL_MapRGB(pBack->format, r,g,b);
+
+        adwDoubled[i] = aulPalette[i] * 0x10001UL;
+    }
+
+    // Build the hi-res pixel pairs for each combination of palette bytes, as they appear in memory
+    for (int i = 0 ; i < N_PALETTE_COLOURS ; i++)
+    {
+        for (int j = 0 ; j < N_PALETTE_COLOURS ; j++)
+        {
+            BYTE ab[2] = { static_cast<BYTE>(i), static_cast<BYTE>(j) };
+            WORD wPair;
+            memcpy(&wPair, ab, sizeof(wPair));
+
+            adwPairs[wPair] = SDL_SwapLE32((aulPalette[j] << 16) | aulPalette[i]);
+        }
     }
 
+    // Darkened scanlines are drawn by scaling the row above, brightened ones from the aulScanline table
+    dwScanScale = (100 + nScanAdjust) * 256 / 100;
+
     // Ensure the display is redrawn to reflect the changes
     Video::SetDirty();
+    fRetained = fCurrent = false;
 }
 
-extern unsigned short int bmp[640 * 480];
+// Draw a scanline row from the row above, or from the SAM line data if brightening
+static void DrawScanline16 (DWORD *pdw_, const DWORD *pdwAbove_, const BYTE *pb_, bool fHiRes_, int nBlocks_, int nWidth_)
+{
+    if (!GetOption(scanlevel))
+        memset(pdw_, 0x00, nWidth_);
+    else if (dwScanScale == 0x100)
+        memcpy(pdw_, pdwAbove_, nWidth_);
+    else if (dwScanScale > 0x100)
+    {
+        // Scaling the 5:6:5 pixels up would clip, so look up the brightened colours instead
+        for (int x = 0 ; x < nBlocks_ ; x++, pb_ += 8)
+        {
+            if (fHiRes_)
+            {
+                pdw_[0] = SDL_SwapLE32((aulScanline[pb_[1]] << 16) | aulScanline[pb_[0]]);
+                pdw_[1] = SDL_SwapLE32((aulScanline[pb_[3]] << 16) | aulScanline[pb_[2]]);
+                pdw_[2] = SDL_SwapLE32((aulScanline[pb_[5]] << 16) | aulScanline[pb_[4]]);
+                pdw_[3] = SDL_SwapLE32((aulScanline[pb_[7]] << 16) | aulScanline[pb_[6]]);
+                pdw_ += 4;
+            }
+            else
+            {
+                pdw_[0] = aulScanline[pb_[0]] * 0x10001UL;
+                pdw_[1] = aulScanline[pb_[1]] * 0x10001UL;
+                pdw_[2] = aulScanline[pb_[2]] * 0x10001UL;
+                pdw_[3] = aulScanline[pb_[3]] * 0x10001UL;
+                pdw_[4] = aulScanline[pb_[4]] * 0x10001UL;
+                pdw_[5] = aulScanline[pb_[5]] * 0x10001UL;
+                pdw_[6] = aulScanline[pb_[6]] * 0x10001UL;
+                pdw_[7] = aulScanline[pb_[7]] * 0x10001UL;
+                pdw_ += 8;
+            }
+        }
+    }
+    else
+    {
+        // Work in 16-bit pixels, so the compiler can vectorise the loop using 16-bit multiplies
+        WORD *pw = reinterpret_cast<WORD*>(pdw_);
+        const WORD *pwAbove = reinterpret_cast<const WORD*>(pdwAbove_);
+        WORD wScale = static_cast<WORD>(dwScanScale);
+
+        for (int x = 0, nPixels = nWidth_ >> 1 ; x < nPixels ; x++)
+        {
+            WORD w = pwAbove[x];
+            WORD wR = static_cast<WORD>(((w >> 11) * wScale + 0x80) >> 8);
+            WORD wG = static_cast<WORD>((((w >> 5) & 0x3f) * wScale + 0x80) >> 8);
+            WORD wB = static_cast<WORD>(((w & 0x1f) * wScale + 0x80) >> 8);
+
+            pw[x] = static_cast<WORD>((wR << 11) | (wG << 5) | wB);
+        }
+    }
+}
+
+// Convert a span of line data to 16-bit in the given buffer, with its scanline below it if interlaced
+static void DrawLine16 (DWORD *pdwTarget_, long lPitchDW_, CScreen* pScreen_, int nLine_, bool fInterlace_, int nFrom_, int nTo_)
+{
+    bool fHiRes = pScreen_->IsHiRes(nLine_);
+    int nBlocks = (nTo_ - nFrom_) >> 3;
+    int nWidth = (nTo_ - nFrom_) << (fHiRes ? 1 : 2);
+
+    long lPitchDW = lPitchDW_ << (fInterlace_ ? 1 : 0);
+    DWORD *pdwBack = pdwTarget_ + lPitchDW*nLine_ + (fHiRes ? (nFrom_ >> 1) : nFrom_), *pdw = pdwBack;
+    const BYTE *pbSAM = pScreen_->GetLine(nLine_) + nFrom_, *pb = pbSAM;
+
+    if (fHiRes)
+    {
+        // Each pair of hi-res pixels is a single lookup
+        const WORD *pw = reinterpret_cast<const WORD*>(pb);
+
+        for (int x = 0 ; x < nBlocks ; x++)
+        {
+            pdw[0] = adwPairs[pw[0]];
+            pdw[1] = adwPairs[pw[1]];
+            pdw[2] = adwPairs[pw[2]];
+            pdw[3] = adwPairs[pw[3]];
+
+            pdw += 4;
+            pw += 4;
+        }
+    }
+    else
+    {
+        for (int x = 0 ; x < nBlocks ; x++)
+        {
+            pdw[0] = adwDoubled[pb[0]];
+            pdw[1] = adwDoubled[pb[1]];
+            pdw[2] = adwDoubled[pb[2]];
+            pdw[3] = adwDoubled[pb[3]];
+            pdw[4] = adwDoubled[pb[4]];
+            pdw[5] = adwDoubled[pb[5]];
+            pdw[6] = adwDoubled[pb[6]];
+            pdw[7] = adwDoubled[pb[7]];
+
+            pdw += 8;
+            pb += 8;
+        }
+    }
+
+    if (fInterlace_)
+        DrawScanline16(pdwBack + lPitchDW_, pdwBack, pbSAM, fHiRes, nBlocks, nWidth);
+
+    // Note the bmp rows changed, for the output stage
+    if (pdwTarget_ == reinterpret_cast<DWORD*>(bmp))
+    {
+        int nRow = nLine_ << (fInterlace_ ? 1 : 0);
+        afRowDirty[nRow] = true;
+        if (fInterlace_) afRowDirty[nRow+1] = true;
+    }
+}
+
+// Convert a freshly drawn SAM display line straight to the back buffer, while it's still in cache
+void RetroVideo::DrawLine (CScreen* pScreen_, int nLine_, int nFrom_, int nTo_)
+{
+    DrawLine16(pdwTarget, lTargetPitchDW, pScreen_, nLine_, true, nFrom_, nTo_);
+    fTargetDrawn = true;
+
+    // Our own buffer now holds the line, so later frames can update just what changes
+    fRetained = (pdwTarget == reinterpret_cast<DWORD*>(bmp));
+    fCurrent = true;
+}
+
+// Does the display buffer still hold the last directly drawn frame?
+bool RetroVideo::IsRetained () const
+{
+    return fRetained;
+}
+
+// Will the frontend still show the last directly drawn frame if nothing new is drawn?
+bool RetroVideo::IsCurrent () const
+{
+    return fCurrent;
+}
+
+// Point the conversion at a frontend framebuffer for the current frame, or back at bmp if NULL or too small
+int Video_SetTarget (void *pv_, int nPitch_, int nWidth_, int nHeight_)
+{
+    int nFrameWidth = Frame::GetWidth(), nFrameHeight = Frame::GetHeight();
+
+    if (!pv_ || nFrameWidth > nWidth_ || nFrameHeight > nHeight_ || (nPitch_ & 3))
+    {
+        // bmp missed any frames drawn to the frontend, so its lines must all be drawn again
+        if (pdwTarget != reinterpret_cast<DWORD*>(bmp))
+            Video::SetDirty();
+
+        pdwTarget = reinterpret_cast<DWORD*>(bmp);
+        lTargetPitchDW = 1280 >> 2;
+        return 0;
+    }
+
+    pdwTarget = reinterpret_cast<DWORD*>(pv_);
+    lTargetPitchDW = nPitch_ >> 2;
+    fRetained = false;
+
+    // The frontend buffer doesn't keep the previous frame, so a frame that isn't drawn directly must draw every line
+    Video::SetDirty();
+
+    // Clear the area outside the frame, which bmp has blank from the start
+    BYTE *pb = reinterpret_cast<BYTE*>(pv_);
+    for (int y = 0 ; y < nHeight_ ; y++, pb += nPitch_)
+    {
+        if (y < nFrameHeight)
+            memset(pb + (nFrameWidth << 1), 0, (nWidth_ - nFrameWidth) << 1);
+        else
+            memset(pb, 0, nWidth_ << 1);
+    }
+
+    return 1;
+}
+
+// Overlays have been drawn over bmp, so the next frame must be drawn in full
+void Video_Invalidate ()
+{
+    fRetained = fCurrent = false;
+
+    for (int i = 0 ; i < 480 ; i++)
+        afRowDirty[i] = true;
+}
+
+// Return whether anything has been drawn to the target since the last call
+int Video_TargetDrawn ()
+{
+    bool fDrawn = fTargetDrawn;
+    fTargetDrawn = false;
+    return fDrawn;
+}
+
+// Convert queued frames, until told to exit
+static void *WorkerThread (void *)
+{
+    pthread_mutex_lock(&mtxWorker);
+
+    while (!fWorkerExit)
+    {
+        if (!pJobScreen)
+        {
+            pthread_cond_wait(&cvWorker, &mtxWorker);
+            continue;
+        }
+
+        // The emulation only touches the job screen again after waiting for us, so convert it unlocked
+        pthread_mutex_unlock(&mtxWorker);
+
+        // The buffers alternate, so every line is converted rather than just those changed since the last frame
+        DWORD *pdw = reinterpret_cast<DWORD*>(awFrames[nJobFrame]);
+        int nHeight = fJobInterlace ? (nJobHeight >> 1) : nJobHeight;
+
+        for (int y = 0 ; y < nHeight ; y++)
+            DrawLine16(pdw, 1280 >> 2, pJobScreen, y, fJobInterlace, 0, pJobScreen->GetWidth(y));
+
+        pthread_mutex_lock(&mtxWorker);
+        pJobScreen = NULL;
+        pthread_cond_broadcast(&cvWorker);
+    }
+
+    pthread_mutex_unlock(&mtxWorker);
+    return NULL;
+}
+
+// Wait for the worker to finish any frame it's converting
+static void WaitWorker ()
+{
+    pthread_mutex_lock(&mtxWorker);
+
+    while (pJobScreen)
+        pthread_cond_wait(&cvWorker, &mtxWorker);
+
+    pthread_mutex_unlock(&mtxWorker);
+}
+
+// Hand a completed frame to the worker, making the one it converted last available for display
+static void QueueFrame (CScreen* pScreen_)
+{
+    WaitWorker();
+
+    if (fJobQueued)
+    {
+        pvLastFrame = awFrames[nJobFrame];
+        nJobFrame ^= 1;
+    }
+
+    // Clear both buffers if the frame size has changed, as the area outside it is never converted
+    int nWidth = Frame::GetWidth(), nHeight = Frame::GetHeight();
+    if (nWidth != nJobWidth || nHeight != nJobHeight)
+    {
+        memset(awFrames, 0, sizeof(awFrames));
+        nJobWidth = nWidth;
+        nJobHeight = nHeight;
+    }
+
+    pthread_mutex_lock(&mtxWorker);
+    fJobInterlace = !GUI::IsActive();
+    fJobQueued = true;
+    fJobShown = false;
+    pJobScreen = pScreen_;
+    pthread_cond_broadcast(&cvWorker);
+    pthread_mutex_unlock(&mtxWorker);
+}
+
+// Enable or disable converting frames on the worker thread, returning whether it's now active
+int Video_SetThreaded (int fThreaded_)
+{
+    bool fNew = !!fThreaded_;
+
+    if (fNew == fThreaded)
+        return fThreaded;
+
+    if (fNew && !fWorkerStarted)
+    {
+        if (pthread_create(&hWorker, NULL, WorkerThread, NULL))
+            return 0;
+
+        fWorkerStarted = true;
+    }
+
+    // Finish any conversion, and forget frames from an earlier threaded run
+    WaitWorker();
+    fJobQueued = fJobShown = false;
+    pvLastFrame = NULL;
+    nJobWidth = nJobHeight = 0;
+
+    // Frame drawing changes path either way, so bmp no longer reflects what's displayed
+    fThreaded = fNew;
+    fRetained = fCurrent = false;
+    return fThreaded;
+}
+
+// Return the last frame completed by the worker, or NULL if there isn't one yet
+const void *Video_ThreadedFrame ()
+{
+    if (!fThreaded)
+        return NULL;
+
+    // If nothing new was queued, the latest job would otherwise wait for a frame that may be a while coming
+    if (fJobShown && fJobQueued)
+    {
+        WaitWorker();
+        pvLastFrame = awFrames[nJobFrame];
+    }
+
+    fJobShown = true;
+    return pvLastFrame;
+}
+
+// Rebuild the output tables if the settings have changed, returning whether the stage is active
+static bool CheckOutput ()
+{
+    int nScale = max(1, min(GetOption(outscale), MAX_OUTPUT_SCALE));
+    bool fRatio5_4 = GetOption(ratio5_4), fCrtMask = GetOption(crtmask);
+
+    // Pass on only the view area, unless overlays may be drawn anywhere in bmp
+    int nSrcW = fOverlay ? 640 : min(Frame::GetWidth(), 640);
+    int nSrcH = fOverlay ? 480 : min(Frame::GetHeight(), 480);
+
+    if (nScale != nOutScale || fRatio5_4 != fOutRatio5_4 || fCrtMask != fOutCrtMask ||
+        nSrcW != nSrcWidth || nSrcH != nSrcHeight)
+    {
+        nOutScale = nScale;
+        fOutRatio5_4 = fRatio5_4;
+        fOutCrtMask = fCrtMask;
+        nSrcWidth = nSrcW;
+        nSrcHeight = nSrcH;
+
+        int nWidth = nSrcWidth * nScale * (fRatio5_4 ? 5 : 4) / 4, nHeight = nSrcHeight * nScale;
+
+        if (nWidth * nHeight != nOutWidth * nOutHeight && pwOutput)
+            free(pwOutput), pwOutput = NULL;
+
+        nOutWidth = nWidth;
+        nOutHeight = nHeight;
+
+        // Nearest source column for each output column, and an aperture grille of red, green and blue columns
+        WORD wLevel = CRT_MASK_LEVEL * 256 / 100;
+        for (int x = 0 ; x < nOutWidth ; x++)
+        {
+            awOutColumn[x] = static_cast<WORD>(x * nSrcWidth / nOutWidth);
+
+            awMaskR[x] = (x % 3 == 0) ? 256 : wLevel;
+            awMaskG[x] = (x % 3 == 1) ? 256 : wLevel;
+            awMaskB[x] = (x % 3 == 2) ? 256 : wLevel;
+        }
+
+        // Redraw everything at the new size, and make sure it's passed on rather than duped
+        Video_Invalidate();
+        fTargetDrawn = true;
+    }
+
+    bool fActive = nOutScale > 1 || fOutRatio5_4 || fOutCrtMask;
+
+    if (fActive && !pwOutput)
+        pwOutput = static_cast<WORD*>(malloc(nOutWidth * nOutHeight * sizeof(WORD)));
+
+    return fActive && pwOutput;
+}
+
+// Scale the brightness of each 5:6:5 channel by the mask for its column
+static void MaskRow (WORD *pw_)
+{
+    // Kept to 16-bit multiplies, so the compiler can vectorise the loop
+    for (int x = 0 ; x < nOutWidth ; x++)
+    {
+        WORD w = pw_[x];
+        WORD wR = static_cast<WORD>(((w >> 11) * awMaskR[x]) >> 8);
+        WORD wG = static_cast<WORD>((((w >> 5) & 0x3f) * awMaskG[x]) >> 8);
+        WORD wB = static_cast<WORD>(((w & 0x1f) * awMaskB[x]) >> 8);
+
+        pw_[x] = static_cast<WORD>((wR << 11) | (wG << 5) | wB);
+    }
+}
+
+// Scale a converted frame row into the output image, filling each output row it covers
+static void OutputRow (WORD *pwOut_, const WORD *pwIn_)
+{
+    if (fOutRatio5_4)
+    {
+        for (int x = 0 ; x < nOutWidth ; x++)
+            pwOut_[x] = pwIn_[awOutColumn[x]];
+    }
+    else if (nOutScale == 1)
+        memcpy(pwOut_, pwIn_, nSrcWidth * sizeof(WORD));
+    else if (nOutScale == 2)
+    {
+        // Both halves are the same pixel, so the byte order doesn't matter
+        DWORD *pdw = reinterpret_cast<DWORD*>(pwOut_);
+
+        for (int x = 0 ; x < nSrcWidth ; x++)
+            pdw[x] = pwIn_[x] * 0x10001UL;
+    }
+    else
+    {
+        for (int x = 0 ; x < nSrcWidth ; x++)
+            pwOut_[x*3] = pwOut_[x*3+1] = pwOut_[x*3+2] = pwIn_[x];
+    }
+
+    if (fOutCrtMask)
+        MaskRow(pwOut_);
+
+    for (int i = 1 ; i < nOutScale ; i++)
+        memcpy(pwOut_ + i*nOutWidth, pwOut_, nOutWidth * sizeof(WORD));
+}
+
+// Change the output stage settings
+void Video_SetOutput (int nScale_, int fRatio5_4_, int fCrtMask_)
+{
+    SetOption(outscale, nScale_);
+    SetOption(ratio5_4, !!fRatio5_4_);
+    SetOption(crtmask, !!fCrtMask_);
+
+    CheckOutput();
+}
+
+// Return whether the output stage is active, and the size of the image passed to the frontend
+int Video_GetOutput (int *pnWidth_, int *pnHeight_)
+{
+    bool fActive = CheckOutput();
+
+    *pnWidth_ = fActive ? nOutWidth : nSrcWidth;
+    *pnHeight_ = fActive ? nOutHeight : nSrcHeight;
+    return fActive;
+}
+
+// Apply the output stage to a converted frame, updating only the rows changed in bmp unless told otherwise
+const void *Video_Output (const void *pvFrame_, int fAll_)
+{
+    if (!CheckOutput())
+        return pvFrame_;
+
+    CProfileSection section(PROF_FLIP);
+
+    const WORD *pwFrame = static_cast<const WORD*>(pvFrame_);
+
+    for (int y = 0 ; y < nSrcHeight ; y++)
+    {
+        if (!fAll_ && !afRowDirty[y])
+            continue;
+
+        OutputRow(pwOutput + y*nOutScale*nOutWidth, pwFrame + y*640);
+        afRowDirty[y] = false;
+    }
+
+    return pwOutput;
+}
+
+// Set whether overlays are being drawn over bmp, outside the view area as well as in it
+void Video_SetOverlay (int fOverlay_)
+{
+    fOverlay = !!fOverlay_;
+    CheckOutput();
+}
+
+// Change the amount of border shown, recreating the frame at the new view size
+void Video_SetBorders (int nBorders_)
+{
+    if (nBorders_ == GetOption(borders))
+        return;
+
+    // The worker mustn't be converting a frame we're about to free
+    WaitWorker();
+
+    SetOption(borders, nBorders_);
+    Frame::Init();
+
+    // Clear what was outside the new view, in case overlays show all of bmp
+    memset(bmp, 0, sizeof(bmp));
+    Video::SetDirty();
+    Video_Invalidate();
+    CheckOutput();
+}
 
 // OpenGL version of DisplayChanges
 bool RetroVideo::DrawChanges (CScreen* pScreen_, bool *pafDirty_)
 {
+    // The GUI view isn't what Frame compares against
+    fRetained = fCurrent = false;
 	
     int nWidth = Frame::GetWidth();
     int nHeight = Frame::GetHeight();
@@ -98,8 +670,8 @@ bool RetroVideo::DrawChanges (CScreen* pScreen_, bool *pafDirty_)
     bool fInterlace = !GUI::IsActive();
     if (fInterlace) nHeight >>= 1;
 
-    DWORD *pdwBack = reinterpret_cast<DWORD*>(bmp), *pdw = pdwBack;
-    long lPitchDW = 1280 >> (fInterlace ? 1 : 2);
+    DWORD *pdwBack = pdwTarget, *pdw = pdwBack;
+    long lPitchDW = lTargetPitchDW << (fInterlace ? 1 : 0);
     bool *pfHiRes = pScreen_->GetHiRes();
 
     BYTE *pbSAM = pScreen_->GetLine(0), *pb = pbSAM;
@@ -113,90 +685,12 @@ bool RetroVideo::DrawChanges (CScreen* pScreen_, bool *pafDirty_)
     {
         case 16:
         {
-            nWidth <<= 1;
-
-            for (int y = 0 ; y < nHeight ; pdw = pdwBack += lPitchDW, pb = pbSAM += lPitch, y++)
+            for (int y = 0 ; y < nHeight ; y++)
             {
-                if (!pafDirty_[y])
-                    continue;
-
-                if (pfHiRes[y])
+                if (pafDirty_[y])
                 {
-                    for (int x = 0 ; x < nRightHi ; x++)
-                    {
-                        pdw[0] = SDL_SwapLE32((aulPalette[pb[1]] << 16) | aulPalette[pb[0]]);
-                        pdw[1] = SDL_SwapLE32((aulPalette[pb[3]] << 16) | aulPalette[pb[2]]);
-                        pdw[2] = SDL_SwapLE32((aulPalette[pb[5]] << 16) | aulPalette[pb[4]]);
-                        pdw[3] = SDL_SwapLE32((aulPalette[pb[7]] << 16) | aulPalette[pb[6]]);
-
-                        pdw += 4;
-                        pb += 8;
-                    }
-
-                    if (fInterlace)
-                    {
-                        pb = pbSAM;
-                        pdw = pdwBack + lPitchDW/2;
-
-                        if (!GetOption(scanlevel))
-                            memset(pdw, 0x00, nWidth);
-                        else
-                        {
-                            for (int x = 0 ; x < nRightHi ; x++)
-                            {
-								pdw[0] = SDL_SwapLE32((aulScanline[pb[1]] << 16) | aulScanline[pb[0]]);
-								pdw[1] = SDL_SwapLE32((aulScanline[pb[3]] << 16) | aulScanline[pb[2]]);
-								pdw[2] = SDL_SwapLE32((aulScanline[pb[5]] << 16) | aulScanline[pb[4]]);
-								pdw[3] = SDL_SwapLE32((aulScanline[pb[7]] << 16) | aulScanline[pb[6]]);
-
-                                pdw += 4;
-                                pb += 8;
-                            }
-                        }
-                    }
-                }
-                else
-                {
-                    for (int x = 0 ; x < nRightLo ; x++)
-                    {
-                        pdw[0] = aulPalette[pb[0]] * 0x10001UL;
-                        pdw[1] = aulPalette[pb[1]] * 0x10001UL;
-                        pdw[2] = aulPalette[pb[2]] * 0x10001UL;
-                        pdw[3] = aulPalette[pb[3]] * 0x10001UL;
-                        pdw[4] = aulPalette[pb[4]] * 0x10001UL;
-                        pdw[5] = aulPalette[pb[5]] * 0x10001UL;
-                        pdw[6] = aulPalette[pb[6]] * 0x10001UL;
-                        pdw[7] = aulPalette[pb[7]] * 0x10001UL;
-
-                        pdw += 8;
-                        pb += 8;
-                    }
-
-                    if (fInterlace)
-                    {
-                        pb = pbSAM;
-                        pdw = pdwBack + lPitchDW/2;
-
-                        if (!GetOption(scanlevel))
-                            memset(pdw, 0x00, nWidth);
-                        else
-                        {
-                            for (int x = 0 ; x < nRightLo ; x++)
-                            {
-                                pdw[0] = aulScanline[pb[0]] * 0x10001UL;
-                                pdw[1] = aulScanline[pb[1]] * 0x10001UL;
-                                pdw[2] = aulScanline[pb[2]] * 0x10001UL;
-                                pdw[3] = aulScanline[pb[3]] * 0x10001UL;
-                                pdw[4] = aulScanline[pb[4]] * 0x10001UL;
-                                pdw[5] = aulScanline[pb[5]] * 0x10001UL;
-                                pdw[6] = aulScanline[pb[6]] * 0x10001UL;
-                                pdw[7] = aulScanline[pb[7]] * 0x10001UL;
-
-                                pdw += 8;
-                                pb += 8;
-                            }
-                        }
-                    }
+                    DrawLine16(pdwTarget, lTargetPitchDW, pScreen_, y, fInterlace, 0, pScreen_->GetWidth(y));
+                    fTargetDrawn = true;
                 }
             }
         }
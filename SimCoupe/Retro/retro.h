@@ -54,6 +54,9 @@ class RetroVideo : public VideoBase
 		bool Init (bool fFirstInit_);
 
 		void Update (CScreen* pScreen_, bool *pafDirty_);
+		void DrawLine (CScreen* pScreen_, int nLine_, int nFrom_, int nTo_);
+		bool IsRetained () const;
+		bool IsCurrent () const;
 		void UpdateSize ();
 		void UpdatePalette ();
 
@@ -55,12 +55,17 @@ $(EMU)/Base/Options.cpp\
 $(EMU)/Base/PNG.cpp\
 $(EMU)/Base/Parallel.cpp\
 $(EMU)/Base/Paula.cpp\
+$(EMU)/Base/Profile.cpp\
+$(EMU)/Base/Resample.cpp\
+$(EMU)/Base/Rewind.cpp\
 $(EMU)/Base/SAA1099.cpp\
+$(EMU)/Base/SAABlip.cpp\
 $(EMU)/Base/SAMVox.cpp\
 $(EMU)/Base/SDIDE.cpp\
 $(EMU)/Base/SID.cpp\
 $(EMU)/Base/Screen.cpp\
 $(EMU)/Base/Sound.cpp\
+$(EMU)/Base/State.cpp\
 $(EMU)/Base/Stream.cpp\
 $(EMU)/Base/Tape.cpp\
 $(EMU)/Base/Util.cpp\
@@ -17,6 +17,30 @@ extern char RPATH[512];
 extern void update_input(void);
 extern void texture_init(void);
 
+extern size_t State_GetSize(void);
+extern int State_Save(void *data, size_t size);
+extern int State_Load(const void *data, size_t size);
+
+extern void CPU_Run1(void);
+extern void CPU_RunAhead(int frames);
+
+extern int Video_SetTarget(void *data, int pitch, int width, int height);
+extern int Video_TargetDrawn(void);
+extern void Video_Invalidate(void);
+extern int Video_SetThreaded(int threaded);
+extern const void *Video_ThreadedFrame(void);
+extern void Video_SetOutput(int scale, int ratio5_4, int crt_mask);
+extern int Video_GetOutput(int *width, int *height);
+extern const void *Video_Output(const void *frame, int all);
+extern void Video_SetOverlay(int overlay);
+extern void Video_SetBorders(int borders);
+extern void Audio_SetSAABlip(int blip);
+extern void Audio_SetVolumes(int dac, int saa, int sid);
+extern void Audio_SetOutput(int rate, int sinc);
+extern void Audio_SetThreaded(int threaded);
+extern void Audio_SetState(bool enabled);
+extern void Audio_Callback(void);
+
 extern unsigned short * sndbuffer;
 extern int sndbufsize;
 signed short rsnd=0;
@@ -25,6 +49,14 @@ static retro_video_refresh_t video_cb;
 static retro_audio_sample_t audio_cb;
 static retro_audio_sample_batch_t audio_batch_cb;
 static retro_environment_t environ_cb;
+
+static int runahead=0;
+static int threaded_video=0;
+static int output_width=TEX_WIDTH, output_height=TEX_HEIGHT;
+static int sample_rate=SAM_SAMPLE_RATE, reported_rate=SAM_SAMPLE_RATE;
+static int audio_thread=0;
+static bool audio_callback_set=false;
+static bool can_dupe=false;
 //static retro_input_poll_t input_poll_cb;
 //static retro_input_state_t input_state_cb;
 
@@ -61,18 +93,149 @@ void retro_get_system_info(struct retro_system_info *info)
    	//info->valid_extensions = NULL; // Anything is fine, we don't care.
 }
 
+// The image is the visible view area, which the output stage may scale up to 3x and stretch to 5:4
+static void get_geometry(struct retro_game_geometry *geom)
+{
+	Video_GetOutput(&output_width, &output_height);
+
+	geom->base_width = output_width;
+	geom->base_height = output_height;
+	geom->max_width = TEX_WIDTH * 3 * 5/4;
+	geom->max_height = TEX_HEIGHT * 3;
+	geom->aspect_ratio = (float)output_width / output_height;
+}
+
 void retro_get_system_av_info(struct retro_system_av_info *info)
 {
-   	struct retro_game_geometry geom = { 256, 192, TEX_WIDTH, TEX_HEIGHT,4.0 / 3.0 };
-   	struct retro_system_timing timing = {60.0,22050.0 };
+   	struct retro_game_geometry geom;
+   	get_geometry(&geom);
+   	struct retro_system_timing timing = { SAM_FPS, sample_rate };
    
    	info->geometry = geom;
    	info->timing   = timing;
+   	reported_rate  = sample_rate;
 }
  
 void retro_set_environment(retro_environment_t cb)
 {
+   	static const struct retro_variable vars[] = {
+      		{ "simcp_runahead", "Run-ahead frames; 0|1|2|3" },
+      		{ "simcp_threaded_video", "Threaded video (a frame behind); disabled|enabled" },
+      		{ "simcp_scale", "Output scale; 1x|2x|3x" },
+      		{ "simcp_aspect", "Aspect ratio; 4:3|5:4" },
+      		{ "simcp_crt_mask", "CRT mask; disabled|enabled" },
+      		{ "simcp_borders", "Borders; Short TV area|No borders|Small borders" },
+      		{ "simcp_saa_engine", "SAA synthesis; Per-sample|Band-limited" },
+      		{ "simcp_dac_volume", "DAC volume; 100%|0%|25%|50%|75%|150%|200%" },
+      		{ "simcp_saa_volume", "SAA volume; 100%|0%|25%|50%|75%|150%|200%" },
+      		{ "simcp_sid_volume", "SID volume; 100%|0%|25%|50%|75%|150%|200%" },
+      		{ "simcp_sample_rate", "Output sample rate; 44100|48000|32000|22050" },
+      		{ "simcp_resampler", "Resampler; Windowed-sinc|Linear" },
+      		{ "simcp_audio_thread", "Threaded audio (restart); disabled|enabled|enabled, wait for space" },
+      		{ NULL, NULL },
+   	};
+
    	environ_cb = cb;
+   	cb(RETRO_ENVIRONMENT_SET_VARIABLES, (void*)vars);
+}
+
+static void update_variables(void)
+{
+   	struct retro_variable var;
+
+   	var.key = "simcp_runahead";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		runahead = atoi(var.value);
+
+   	var.key = "simcp_threaded_video";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		threaded_video = !strcmp(var.value, "enabled");
+
+   	int scale = 1, ratio5_4 = 0, crt_mask = 0;
+
+   	var.key = "simcp_scale";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		scale = atoi(var.value);
+
+   	var.key = "simcp_aspect";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		ratio5_4 = !strcmp(var.value, "5:4");
+
+   	var.key = "simcp_crt_mask";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		crt_mask = !strcmp(var.value, "enabled");
+
+   	Video_SetOutput(scale, ratio5_4, crt_mask);
+
+   	var.key = "simcp_borders";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		Video_SetBorders(!strcmp(var.value, "No borders") ? 0 : !strcmp(var.value, "Small borders") ? 1 : 2);
+
+   	var.key = "simcp_saa_engine";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		Audio_SetSAABlip(!strcmp(var.value, "Band-limited"));
+
+   	int dac_volume = 100, saa_volume = 100, sid_volume = 100;
+
+   	var.key = "simcp_dac_volume";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		dac_volume = atoi(var.value);
+
+   	var.key = "simcp_saa_volume";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		saa_volume = atoi(var.value);
+
+   	var.key = "simcp_sid_volume";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		sid_volume = atoi(var.value);
+
+   	Audio_SetVolumes(dac_volume, saa_volume, sid_volume);
+
+   	int sinc = 1;
+
+   	var.key = "simcp_sample_rate";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		sample_rate = atoi(var.value);
+
+   	var.key = "simcp_resampler";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		sinc = strcmp(var.value, "Linear") != 0;
+
+   	Audio_SetOutput(sample_rate, sinc);
+
+   	var.key = "simcp_audio_thread";
+   	var.value = NULL;
+
+   	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      		audio_thread = !strcmp(var.value, "enabled, wait for space") ? 2 : !strcmp(var.value, "enabled");
+
+   	// The audio callback is only registered when loading, so later changes just switch the waiting
+   	if (audio_callback_set)
+      		Audio_SetThreaded(audio_thread ? audio_thread : 1);
 }
 
 void retro_set_audio_sample(retro_audio_sample_t cb)
@@ -107,6 +270,10 @@ void retro_audio_cb( short l, short r){
 	audio_cb(l,r);
 }
 
+void retro_audio_batch(const short *data, size_t frames){
+	audio_batch_cb(data,frames);
+}
+
 int MMENU=0;
 extern unsigned long  Ktime , LastFPSTime;
 
@@ -138,10 +305,59 @@ void retro_run(void)
   		rload=0;
 	}
 
+	bool updated = false;
+	if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
+		update_variables();
+
+	// Tell the frontend about a new output rate, which the audio is resampled to
+	if (sample_rate != reported_rate){
+		struct retro_system_av_info info;
+		retro_get_system_av_info(&info);
+		environ_cb(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &info);
+	}
+
+	// Tell the frontend if the image size has changed, such as for the output stage or the keyboard overlay needing all of bmp
+	Video_SetOverlay(SHOWKEY==1);
+
+	int width, height;
+	int output = Video_GetOutput(&width, &height);
+
+	if (width != output_width || height != output_height){
+		struct retro_game_geometry geom;
+		get_geometry(&geom);
+		environ_cb(RETRO_ENVIRONMENT_SET_GEOMETRY, &geom);
+	}
+
+	// Convert frames on a worker thread if enabled, except while the keyboard is drawn over bmp
+	int threaded = Video_SetThreaded(threaded_video && SHOWKEY!=1);
+	const void *threaded_frame;
+
+	// Render straight into the frontend's framebuffer if it has one, unless bmp overlays are showing or the output stage needs bmp
+	struct retro_framebuffer fb;
+	void *frame = bmp;
+	size_t pitch = TEX_WIDTH << 1;
+
+	memset(&fb, 0, sizeof(fb));
+	fb.width = width;
+	fb.height = height;
+	fb.access_flags = RETRO_MEMORY_ACCESS_WRITE;
+
+	if (!threaded && !output && can_dupe && SHOWKEY!=1 && environ_cb(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, &fb) &&
+	    fb.format == RETRO_PIXEL_FORMAT_RGB565 && Video_SetTarget(fb.data, fb.pitch, width, height)){
+		frame = fb.data;
+		pitch = fb.pitch;
+	}
+	else
+		Video_SetTarget(NULL, 0, 0, 0);
+
 	if(pauseg==0){
 
-		CPU_Run1();	
+		if(runahead>0)CPU_RunAhead(runahead);
+		else CPU_Run1();	
 		update_input();//moved to MSX.c
+
+		// The virtual keyboard is drawn over bmp, so it can't be updated from just the changed lines
+		if(SHOWKEY==1)Video_Invalidate();
 		//if(SND==1)sndfill();//moved to MSX.c
 
 	}
@@ -151,7 +367,17 @@ void retro_run(void)
 		MMENU=1;pauseg=0;
 	}
 
-	/*if(SHOWKEY==1)*/video_cb(bmp,TEX_WIDTH, TEX_HEIGHT, TEX_WIDTH << 1);
+	// Show the last frame the worker finished, which is a frame behind the emulation
+	if(threaded && (threaded_frame = Video_ThreadedFrame()))
+		video_cb(Video_Output(threaded_frame, 1),width, height, output ? width << 1 : TEX_WIDTH << 1);
+	// Nothing new drawn? Dupe the last frame, as a frontend buffer won't have kept it (bmp may have new overlays)
+	else if(!Video_TargetDrawn() && can_dupe && (frame!=bmp || SHOWKEY!=1))
+		video_cb(NULL,width, height, output ? width << 1 : pitch);
+	// Frames in bmp pass through the output stage, which only redoes the rows that changed
+	else if(frame==bmp)
+		video_cb(Video_Output(bmp, 0),width, height, output ? width << 1 : pitch);
+	else
+		video_cb(frame,width, height, pitch);
    	//else  video_cb(bmp,272,256, 640*2); 
 
 }
@@ -210,6 +436,9 @@ bool retro_load_game(const struct retro_game_info *info)
     		return false;
     	}
 
+    	if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &can_dupe))
+    		can_dupe = false;
+
     	struct retro_keyboard_callback cb = { keyboard_cb };
     	environ_cb(RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK, &cb);
 
@@ -218,6 +447,17 @@ bool retro_load_game(const struct retro_game_info *info)
     	full_path = info->path;
 
     	strcpy(RPATH,full_path); 
+
+    	update_variables();
+
+    	// Queue audio for the frontend's audio thread if enabled and supported
+    	if (audio_thread){
+    		struct retro_audio_callback acb = { Audio_Callback, Audio_SetState };
+    		if (environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_CALLBACK, &acb)){
+    			audio_callback_set = true;
+    			Audio_SetThreaded(audio_thread);
+    		}
+    	}
 //g_fPaused= true;
 
     	return true;
@@ -240,17 +480,17 @@ bool retro_load_game_special(unsigned type, const struct retro_game_info *info,
 
 size_t retro_serialize_size(void)
 {
-   	return 0;
+   	return State_GetSize();
 }
 
 bool retro_serialize(void *data_, size_t size)
 {
-   	return false;
+   	return State_Save(data_, size) != 0;
 }
 
 bool retro_unserialize(const void *data_, size_t size)
 {
-	return false;
+	return State_Load(data_, size) != 0;
 }
 
 void *retro_get_memory_data(unsigned id)
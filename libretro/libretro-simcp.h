@@ -13,6 +13,11 @@
 
 #include <stdbool.h>
 
+//SAM TIMING: frame rate from the emulated CPU clock and frame length (50.08Hz)
+#include "SAM.h"
+#define SAM_FPS         ((double)REAL_TSTATES_PER_SECOND / TSTATES_PER_FRAME)
+#define SAM_SAMPLE_RATE 44100.0
+
 #define TEX_WIDTH 640
 #define TEX_HEIGHT 480
 #define CROP_WIDTH 640
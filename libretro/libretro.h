@@ -415,6 +415,37 @@ enum retro_mod
 #define RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK 12
                                            // const struct retro_keyboard_callback * --
                                            // Sets a callback function used to notify core about keyboard events.
+#define RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE 17
+                                           // bool * --
+                                           // Result is set to true if some variables are updated by
+                                           // frontend since last call to RETRO_ENVIRONMENT_GET_VARIABLE.
+                                           // Variables should be queried with GET_VARIABLE.
+#define RETRO_ENVIRONMENT_SET_AUDIO_CALLBACK 22
+                                           // const struct retro_audio_callback * --
+                                           // Sets an interface used to tell the core when audio can be written.
+                                           // The callback can be called from any thread, so the core's audio must be thread safe,
+                                           // and the normal audio callbacks must be called from within it.
+                                           // This should be called inside retro_load_game().
+#define RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO 32
+                                           // const struct retro_system_av_info * --
+                                           // Sets a new av_info structure, such as for a changed sample rate.
+                                           // This can only be called from within retro_run().
+#define RETRO_ENVIRONMENT_SET_GEOMETRY 37
+                                           // const struct retro_game_geometry * --
+                                           // Changes the base size and aspect ratio of the video output, which must stay
+                                           // within the maximum size from retro_get_system_av_info.
+                                           // This can only be called from within retro_run().
+
+#define RETRO_ENVIRONMENT_EXPERIMENTAL 0x10000
+                                           // Environment commands which are experimental use RETRO_ENVIRONMENT_EXPERIMENTAL.
+#define RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER (40 | RETRO_ENVIRONMENT_EXPERIMENTAL)
+                                           // struct retro_framebuffer * --
+                                           // Returns a preallocated framebuffer which the core can use for rendering
+                                           // the frame into when not using SET_HW_RENDER.
+                                           // The framebuffer returned from this call must not be used after the current
+                                           // call to retro_run() returns.
+                                           // The core must pass the framebuffer's data pointer to video_refresh,
+                                           // and it must match the returned width, height and pitch.
 
 
 // Callback type passed in RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK. Called by the frontend in response to keyboard events.
@@ -429,6 +460,17 @@ struct retro_keyboard_callback
     retro_keyboard_event_t callback;
 };
 
+// Callbacks passed in RETRO_ENVIRONMENT_SET_AUDIO_CALLBACK.
+// The first is called when the frontend wants more audio, and the second when it starts or stops doing so.
+typedef void (*retro_audio_callback_t)(void);
+typedef void (*retro_audio_set_state_callback_t)(bool enabled);
+
+struct retro_audio_callback
+{
+    retro_audio_callback_t callback;
+    retro_audio_set_state_callback_t set_state;
+};
+
 enum retro_pixel_format
 {
    // 0RGB1555, native endian. 0 bit must be set to 0.
@@ -448,6 +490,25 @@ enum retro_pixel_format
    RETRO_PIXEL_FORMAT_UNKNOWN  = INT_MAX
 };
 
+#define RETRO_MEMORY_ACCESS_WRITE (1 << 0)
+                                           // The core will write to the buffer provided by retro_framebuffer::data.
+#define RETRO_MEMORY_ACCESS_READ (1 << 1)
+                                           // The core will read from retro_framebuffer::data.
+#define RETRO_MEMORY_TYPE_CACHED (1 << 0)
+                                           // The memory in data is cached.
+                                           // If not cached, random writes and/or reading from the buffer is expected to be very slow.
+
+struct retro_framebuffer
+{
+   void *data;                   // The framebuffer which the core can render into. Set by frontend in GET_CURRENT_SOFTWARE_FRAMEBUFFER.
+   unsigned width;               // The framebuffer width used by the core. Set by core.
+   unsigned height;              // The framebuffer height used by the core. Set by core.
+   size_t pitch;                 // The number of bytes between the beginning of a scanline, and beginning of the next scanline. Set by frontend.
+   enum retro_pixel_format format; // The pixel format the core must use to render into data. Set by frontend.
+   unsigned access_flags;        // How the core will access the memory in the framebuffer. RETRO_MEMORY_ACCESS_* flags. Set by core.
+   unsigned memory_flags;        // Flags telling core how the memory has been mapped. RETRO_MEMORY_TYPE_* flags. Set by frontend.
+};
+
 struct retro_message
 {
    const char *msg;        // Message to be displayed.
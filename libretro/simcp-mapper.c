@@ -18,6 +18,7 @@
 extern const char keyboard_translation[320];
 
 extern char * filebrowser(const char *path_and_name);
+extern void Video_Invalidate(void);
 
 unsigned short int bmp[TEX_WIDTH * TEX_HEIGHT];
 
@@ -195,6 +196,8 @@ void Print_Statut(){
 	Draw_text(bmp,STAT_DECX+120,10,0xffff,0x8080,1,2,40,"JOY%c",NUMjoy>0?'1':'2');
         Draw_text(bmp,STAT_DECX+40 ,20,0xffff,0x8080,1,2,40,"mx:%d my:%d (%d,%d)",tomx,tomy,fmousex,fmousey);
 
+	// Drawn over bmp, so the output stage must redo the frame
+	Video_Invalidate();
 }
 
 /*
@@ -213,6 +216,7 @@ Y   fMSX Menu
 
 void Screen_SetFullUpdate(){	
 	//memset(bmp, 0, sizeof(bmp));
+	Video_Invalidate();
 }
 
 void retro_mouse(int a,int b){    